@@ -35,7 +35,7 @@ for f in os.listdir(path.join(data_path,'geometric_with_coords',expdir)):
 			  full_target_path,
 			  '-c',str(capacity),
 			  '-g','1',
-			  '-a','1',
+			  '-a','0',
 			  '-n',str(facilities),
 			  '-o',path.join(data_path,'geometric_with_coords',expdir,'solutions','fcla',id + "fac" + str(facilities) + ".json")],
 			  stdout=subprocess.PIPE,
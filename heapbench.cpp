@@ -0,0 +1,190 @@
+/*
+ * Micro-benchmark of heap policies (see HeapPolicy.h) for every site that uses a heap:
+ * Dijkstra heaps of the exploring edge generators, dheap and gheap of Matcher and the coverage heap of FacilityChooser.
+ *
+ * Runs on a given network or on a random geometric graph, prints the time of every policy per site.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <boost/program_options.hpp>
+#include <igraph/igraph.h>
+
+#include "helpers.h"
+#include "Network.h"
+#include "Logger.h"
+#include "FacilityRank.h"
+#include "nheap.h"
+#include "HeapPolicy.h"
+#include "ExploringEdgeGenerator.h"
+#include "TargetExploringEdgeGenerator.h"
+#include "Matcher.h"
+
+using namespace std;
+namespace po = boost::program_options;
+
+//fHeap for comparison, valid for increasing order only
+struct LegacyHeapPolicy {
+    template<class V, class I, class Compare = std::less<V>>
+    using heap = fHeap<V, I>;
+};
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*
+ * The first <edges_per_customer> nearest nodes of every customer
+ */
+template<typename H>
+double benchmark_generator(Network& network, long edges_per_customer) {
+    auto start = std::chrono::steady_clock::now();
+    ExploringEdgeGenerator<long, long, H> generator(network);
+    for (long i = 0; i < generator.n; i++) {
+        for (long k = 0; k < edges_per_customer; k++) {
+            if (!generator.getEdge(i).exists) {
+                break;
+            }
+        }
+    }
+    return seconds_since(start);
+}
+
+/*
+ * Matching of unit demands and a few rounds of demand increases, as in WMA iterations
+ */
+template<typename H>
+double benchmark_matcher(Network& network, std::vector<long>& facilities, long capacity, long rounds) {
+    auto start = std::chrono::steady_clock::now();
+    TargetExploringEdgeGenerator<long, long> generator(network, facilities);
+    std::vector<long> excess(network.source_indexes.size() + facilities.size(), capacity);
+    for (long i = 0; i < network.source_indexes.size(); i++) {
+        excess[i] = -1;
+    }
+    Logger logger;
+    Matcher<long, long, long, H> matcher(&generator, excess, &logger);
+    matcher.match();
+    for (long round = 0; round < rounds; round++) {
+        for (long i = 0; i < network.source_indexes.size(); i++) {
+            matcher.increaseCapacity(i);
+        }
+    }
+    return seconds_since(start);
+}
+
+/*
+ * Lazy greedy set cover: take the facility with the largest coverage, recalculate it and enqueue it back
+ * if it has decreased, as in FacilityChooser::pickAnotherFacility
+ */
+template<typename H>
+double benchmark_coverage(long facility_count, long picks) {
+    std::mt19937_64 rng(1);
+    auto start = std::chrono::steady_clock::now();
+    typename H::template heap<FacilityRank, long, std::greater<FacilityRank>> heap;
+    for (long i = 0; i < facility_count; i++) {
+        heap.enqueue(i, FacilityRank(rng() % 1000, rng() % 100, i));
+    }
+    long picked = 0;
+    long facility;
+    FacilityRank rank;
+    while (picked < picks && heap.dequeue(facility, rank)) {
+        long lost = rng() % 4 == 0 ? 0 : rng() % (rank.coverage + 1);
+        if (lost == 0) {
+            picked++;
+        } else {
+            heap.enqueue(facility, FacilityRank(rank.coverage - lost, rank.lastUsed, rank.id));
+        }
+    }
+    return seconds_since(start);
+}
+
+template<typename H>
+void report(std::string site, std::string policy, H benchmark) {
+    try {
+        double seconds = benchmark();
+        cout << site << "\t" << policy << "\t" << seconds << endl;
+    } catch (std::logic_error& e) {
+        cout << site << "\t" << policy << "\tn/a: " << e.what() << endl;
+    }
+}
+
+int main(int argc, const char** argv) {
+    string filename;
+    long size;
+    long source_step;
+    long facility_step;
+    long edges_per_customer;
+    long capacity;
+    long rounds;
+    long facility_count;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+            ("help,h", "produce help message")
+            ("input,i", po::value<string>(&filename)->default_value(""), "Input file, a network. Random geometric graph if empty")
+            ("size,s", po::value<long>(&size)->default_value(10000), "Number of nodes of a random geometric graph")
+            ("sources,r", po::value<long>(&source_step)->default_value(3), "Every n-th node of a random graph is a customer")
+            ("facilities,f", po::value<long>(&facility_step)->default_value(5), "Every n-th node is a facility for matching")
+            ("edges,e", po::value<long>(&edges_per_customer)->default_value(100), "Edges per customer from the generator")
+            ("faccap,c", po::value<long>(&capacity)->default_value(6), "Capacity of facilities for matching")
+            ("rounds,k", po::value<long>(&rounds)->default_value(2), "Rounds of demand increases in matching")
+            ("coverage,n", po::value<long>(&facility_count)->default_value(1000000), "Number of facilities in the coverage heap");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    if (vm.count("help")) {
+        cout << desc << "\n";
+        return 1;
+    }
+    po::notify(vm);
+
+    Network* network;
+    if (filename.empty()) {
+        igraph_t graph;
+        igraph_vector_t x, y;
+        std::vector<long> weights;
+        generate_random_geometric_graph(size, 2.0 / sqrt((double) size), &graph, weights, &x, &y);
+        std::vector<long> sources;
+        for (long i = 0; i < size; i += source_step) {
+            sources.push_back(i);
+        }
+        network = new Network(&graph, weights, sources);
+        igraph_destroy(&graph);
+        igraph_vector_destroy(&x);
+        igraph_vector_destroy(&y);
+    } else {
+        network = new Network(filename);
+    }
+    std::vector<long> facilities;
+    for (long i = 1; i < network->graph_size(); i += facility_step) {
+        facilities.push_back(i);
+    }
+
+    cout << "site\tpolicy\tseconds" << endl;
+    report("generator", "fHeap", [&]() { return benchmark_generator<LegacyHeapPolicy>(*network, edges_per_customer); });
+    report("generator", "binary", [&]() { return benchmark_generator<BinaryHeapPolicy>(*network, edges_per_customer); });
+    report("generator", "4-ary", [&]() { return benchmark_generator<DaryHeapPolicy<4>>(*network, edges_per_customer); });
+    report("generator", "8-ary", [&]() { return benchmark_generator<DaryHeapPolicy<8>>(*network, edges_per_customer); });
+    report("generator", "pairing", [&]() { return benchmark_generator<PairingHeapPolicy>(*network, edges_per_customer); });
+    report("generator", "radix", [&]() { return benchmark_generator<RadixHeapPolicy>(*network, edges_per_customer); });
+
+    report("matcher", "fHeap", [&]() { return benchmark_matcher<LegacyHeapPolicy>(*network, facilities, capacity, rounds); });
+    report("matcher", "binary", [&]() { return benchmark_matcher<BinaryHeapPolicy>(*network, facilities, capacity, rounds); });
+    report("matcher", "4-ary", [&]() { return benchmark_matcher<DaryHeapPolicy<4>>(*network, facilities, capacity, rounds); });
+    report("matcher", "8-ary", [&]() { return benchmark_matcher<DaryHeapPolicy<8>>(*network, facilities, capacity, rounds); });
+    report("matcher", "pairing", [&]() { return benchmark_matcher<PairingHeapPolicy>(*network, facilities, capacity, rounds); });
+    report("matcher", "radix", [&]() { return benchmark_matcher<RadixHeapPolicy>(*network, facilities, capacity, rounds); });
+
+    report("coverage", "binary", [&]() { return benchmark_coverage<BinaryHeapPolicy>(facility_count, facility_count / 10); });
+    report("coverage", "4-ary", [&]() { return benchmark_coverage<DaryHeapPolicy<4>>(facility_count, facility_count / 10); });
+    report("coverage", "8-ary", [&]() { return benchmark_coverage<DaryHeapPolicy<8>>(facility_count, facility_count / 10); });
+    report("coverage", "pairing", [&]() { return benchmark_coverage<PairingHeapPolicy>(facility_count, facility_count / 10); });
+    report("coverage", "bucket", [&]() { return benchmark_coverage<BucketQueuePolicy>(facility_count, facility_count / 10); });
+
+    delete network;
+    return 0;
+}
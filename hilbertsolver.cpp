@@ -14,12 +14,28 @@
 using namespace std;
 namespace po = boost::program_options;
 
+template<typename Solver>
+void solve(Network& net, Logger& logger, bool auction_objective, long facility_number_to_locate, long facility_capacity,
+           string out_filename) {
+    Solver hilbert_solver(&net, &logger);
+    hilbert_solver.auction_objective = auction_objective;
+    hilbert_solver.run(facility_number_to_locate, facility_capacity);
+    if (logger.str_dict.count("error") > 0) {
+        cout << "Error " << logger.str_dict["error"][0] << endl;
+    } else {
+        cout << logger.float_dict["objective"][0] << " " << logger.float_dict["runtime"][0] << endl;
+    }
+    logger.finish("total time");
+    hilbert_solver.save_log(out_filename);
+}
+
 int main(int argc, const char** argv) {
     string filename;
     long facility_number_to_locate;
     long facility_capacity;
     string out_filename;
     string facilityfile;
+    bool auction_objective;
 
     po::options_description desc("Allowed options");
     desc.add_options()
@@ -28,6 +44,7 @@ int main(int argc, const char** argv) {
             ("facilityfile,f", po::value<string>(&facilityfile)->default_value(""), "File with a list of facilities")
             ("facilities,n", po::value<long>(&facility_number_to_locate)->required(), "Facilities to locate")
             ("faccap,c", po::value<long>(&facility_capacity)->default_value(1), "Capacity of facilities")
+            ("auction,u", po::value<bool>(&auction_objective)->default_value(false), "Calculate objective with the auction algorithm")
             ("output,o", po::value<string>(&out_filename)->required(), "Output file");
 
     po::variables_map vm;
@@ -47,15 +64,14 @@ int main(int argc, const char** argv) {
 //    }
     try {
         Network net(filename,facilityfile);
-        HilbertSolver hilbert_solver = HilbertSolver(&net, &logger);
-        hilbert_solver.run(facility_number_to_locate, facility_capacity);
-        if (logger.str_dict.count("error") > 0) {
-            cout << "Error " << logger.str_dict["error"][0] << endl;
+        //32-bit ids and weights of the matching if the network is small enough
+        if (Matcher<long,int32_t,int32_t>::fitsNetwork(net)) {
+            logger.add("index bits", 32);
+            solve<HilbertSolver32>(net, logger, auction_objective, facility_number_to_locate, facility_capacity, out_filename);
         } else {
-            cout << logger.float_dict["objective"][0] << " " << logger.float_dict["runtime"][0] << endl;
+            logger.add("index bits", 64);
+            solve<HilbertSolver>(net, logger, auction_objective, facility_number_to_locate, facility_capacity, out_filename);
         }
-        logger.finish("total time");
-        hilbert_solver.save_log(out_filename);
     } catch (const std::string& e) {
         std::cout << e << std::endl;
     }
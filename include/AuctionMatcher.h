@@ -0,0 +1,358 @@
+/*
+ * Match customers to facilities with the auction algorithm (epsilon scaling), alternative to SIA in Matcher
+ * when the set of facilities is fixed, e.g. for computing the objective.
+ *
+ * Customers have unit demand (negative excess of -1), facilities have capacities (positive excess), and there is one
+ * extra node at the end with weight VERY_BIG_W, as in Matcher. Every unit of capacity is a slot with its own price;
+ * a bidder takes the cheapest slot of the object that minimizes weight + price and raises the price of the slot
+ * by the difference to the second best option plus epsilon.
+ *
+ * The auction is exact only if every slot is taken at the end, so the problem is made symmetric:
+ * unused capacity of a facility is taken by "fillers" with zero weight, which can stay in their facility
+ * or move to the extra node, and the extra node has one slot per customer. Then customers + fillers = slots,
+ * and the usual epsilon scaling (assignments are reset after each phase, prices are kept) applies.
+ * Weights are multiplied by (bidders + 1), so the epsilon-optimal result of the last phase (epsilon = 1)
+ * is optimal for the original weights.
+ *
+ * Edges are taken from the edge generator lazily: prices are never negative, so edges that are not generated yet
+ * cost at least the weight of the next edge of the customer. New edges are generated only while that bound is
+ * smaller than the second best option.
+ *
+ * Bids of all unassigned bidders in a round are computed in parallel (OpenMP) and resolved sequentially
+ * in a fixed order, so the result does not depend on the number of threads.
+ */
+
+#ifndef FCLA_AUCTIONMATCHER_H
+#define FCLA_AUCTIONMATCHER_H
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "helpers.h"
+#include "Network.h"
+#include "EdgeGenerator.h"
+#include "Logger.h"
+
+template<typename F, typename W, typename I>
+class AuctionMatcher {
+public:
+    typedef long Cost; //scaled weights, prices and epsilon: weights times the number of bidders may not fit into W
+    const Cost INF_COST = std::numeric_limits<Cost>::max();
+    const W VERY_BIG_W = EXTRA_NODE_WEIGHT; // weight of an assignment to the extra node
+    const Cost EPS_SCALE_FACTOR = 8; // epsilon is divided by this factor after every phase
+    const I FREE_SLOT = -1;
+
+    EdgeGenerator* edge_generator;
+    Logger* logger;
+    bool allow_extra_node_assignment;
+    std::vector<F> node_excess;
+    I source_count;
+    I facility_count; //without the extra node
+    W result_weight;
+    long bid_count;
+    long phase_count;
+
+    AuctionMatcher(EdgeGenerator* edge_generator, std::vector<F>& node_excess, Logger* logger, bool allow_extra_node_assignment=true) {
+        this->edge_generator = edge_generator;
+        this->logger = logger;
+        this->allow_extra_node_assignment = allow_extra_node_assignment;
+        this->source_count = edge_generator->n;
+        this->facility_count = edge_generator->m;
+        this->node_excess = node_excess;
+        this->node_excess.push_back(std::numeric_limits<F>::max()); //extra node
+        this->result_weight = 0;
+        this->bid_count = 0;
+        this->phase_count = 0;
+    }
+
+    ~AuctionMatcher() {}
+
+    /*
+     * Run epsilon-scaling phases until every customer is assigned with epsilon = 1
+     */
+    void match() {
+        init();
+        Cost epsilon = this->initialEpsilon();
+        while (true) {
+            this->phase_count++;
+            this->runAuction(epsilon);
+            if (epsilon == 1) {
+                break;
+            }
+            epsilon = std::max((Cost) 1, epsilon / EPS_SCALE_FACTOR);
+        }
+        //update excesses as Matcher does
+        for (I i = 0; i < source_count; i++) {
+            if (assigned[i] != FREE_SLOT) {
+                node_excess[i] += 1;
+                node_excess[assigned[i] == facility_count ? getExtraNodeIndex() : source_count + assigned[i]] -= 1;
+            }
+        }
+        logger->add("auction phases", phase_count);
+        logger->add("auction bids", bid_count);
+    }
+
+    void calculateResult() {
+        result_weight = 0;
+        for (I i = 0; i < source_count; i++) {
+            if (assigned[i] == facility_count) {
+                if (!allow_extra_node_assignment) {
+                    throw std::logic_error("WMA produced infesible solution");
+                }
+                continue; //the extra node is not counted, as in Matcher
+            }
+            if (assigned[i] != FREE_SLOT) {
+                result_weight += assigned_weight[i];
+            }
+        }
+    }
+
+    inline I getExtraNodeIndex() {
+        return this->node_excess.size()-1;
+    }
+
+private:
+    struct Slot {
+        Cost price;
+        I holder; //customer id, filler id (see fillerOf) or FREE_SLOT
+    };
+    struct Bid {
+        I object;
+        Cost price;
+        bool needs_edges;
+    };
+
+    Cost scale;
+    std::vector<std::vector<std::pair<I,W>>> known_edges; //generated edges per customer: facility and weight
+    std::vector<newEdge> next_edges; //the next edge of a customer that is not yet in known_edges
+    std::vector<std::vector<Slot>> slots; //min-heap of slots by price per facility, the last one is the extra node
+    std::vector<I> assigned; //object of a customer (facility_count for the extra node) or FREE_SLOT
+    std::vector<W> assigned_weight;
+    std::vector<I> bidders;
+    std::vector<Bid> bids;
+
+    /*
+     * Fillers of facility j are identical, so they are identified by the facility only
+     */
+    inline I fillerOf(I facility) {
+        return -2 - facility;
+    }
+
+    inline I fillerFacility(I bidder) {
+        return -2 - bidder;
+    }
+
+    void init() {
+        known_edges.assign(source_count, std::vector<std::pair<I,W>>());
+        next_edges.resize(source_count);
+        assigned.assign(source_count, FREE_SLOT);
+        assigned_weight.assign(source_count, 0);
+        slots.assign(facility_count + 1, std::vector<Slot>());
+        I bidder_count = 0;
+        for (I j = 0; j < facility_count; j++) {
+            F capacity = std::max((F) 0, node_excess[source_count + j]);
+            slots[j].assign(capacity, Slot{0, FREE_SLOT});
+            bidder_count += capacity;
+        }
+        edge_generator->reset();
+        I demand = 0;
+        for (I i = 0; i < source_count; i++) {
+            if (node_excess[i] != -1 && node_excess[i] != 0) {
+                throw std::logic_error("Auction matching supports only unit demands of customers");
+            }
+            demand -= node_excess[i];
+            next_edges[i] = edge_generator->getEdge(i);
+        }
+        slots[facility_count].assign(demand, Slot{0, FREE_SLOT});
+        bidder_count += demand;
+        this->scale = bidder_count + 1;
+    }
+
+    /*
+     * Half of the largest first edge, in scaled weights
+     */
+    Cost initialEpsilon() {
+        Cost max_weight = 0;
+        for (I i = 0; i < source_count; i++) {
+            if (next_edges[i].exists) {
+                max_weight = std::max(max_weight, (Cost) next_edges[i].weight);
+            }
+        }
+        return std::max((Cost) 1, max_weight * scale / 2);
+    }
+
+    inline Cost minPrice(I object) {
+        std::vector<Slot>& heap = slots[object];
+        return heap.empty() ? INF_COST : heap[0].price;
+    }
+
+    inline Cost secondPrice(I object) {
+        std::vector<Slot>& heap = slots[object];
+        if (heap.size() < 2) {
+            return INF_COST;
+        }
+        return heap.size() == 2 ? heap[1].price : std::min(heap[1].price, heap[2].price);
+    }
+
+    inline Cost slotCost(W weight, Cost price) {
+        return price == INF_COST ? INF_COST : (Cost) weight * scale + price;
+    }
+
+    inline void updateOptions(I object, Cost cost, I& best, Cost& c1, Cost& c2) {
+        if (cost < c1) {
+            c2 = c1;
+            c1 = cost;
+            best = object;
+        } else if (cost < c2) {
+            c2 = cost;
+        }
+    }
+
+    /*
+     * Best object with the best and the second best cost among generated edges and the extra node
+     * The second best may be the next slot of the best object
+     */
+    void bestOptions(I source_id, I& best, W& best_weight, Cost& c1, Cost& c2) {
+        best = -1;
+        c1 = INF_COST;
+        c2 = INF_COST;
+        updateOptions(facility_count, slotCost(VERY_BIG_W, minPrice(facility_count)), best, c1, c2);
+        best_weight = VERY_BIG_W;
+        for (auto& edge : known_edges[source_id]) {
+            I prev_best = best;
+            updateOptions(edge.first, slotCost(edge.second, minPrice(edge.first)), best, c1, c2);
+            if (best != prev_best) {
+                best_weight = edge.second;
+            }
+        }
+        c2 = std::min(c2, slotCost(best_weight, secondPrice(best)));
+    }
+
+    inline Cost generatedBound(I source_id) {
+        return next_edges[source_id].exists ? (Cost) next_edges[source_id].weight * scale : INF_COST;
+    }
+
+    Bid computeBid(I bidder, Cost epsilon) {
+        I best;
+        W best_weight;
+        Cost c1, c2;
+        Bid bid;
+        bid.needs_edges = false;
+        if (bidder >= 0) {
+            bestOptions(bidder, best, best_weight, c1, c2);
+            bid.needs_edges = generatedBound(bidder) < c2;
+        } else {
+            //a filler can stay in its facility or go to the extra node, both with zero weight
+            best = -1;
+            c1 = INF_COST;
+            c2 = INF_COST;
+            I facility = fillerFacility(bidder);
+            updateOptions(facility, minPrice(facility), best, c1, c2);
+            updateOptions(facility_count, minPrice(facility_count), best, c1, c2);
+            c2 = std::min(c2, secondPrice(best));
+        }
+        bid.object = best;
+        //with a single option the price is raised by epsilon only
+        bid.price = c1 + (c2 == INF_COST ? 0 : c2 - c1) + epsilon - (c1 - minPrice(best));
+        return bid;
+    }
+
+    void addNextEdge(I source_id) {
+        newEdge& e = next_edges[source_id];
+        known_edges[source_id].push_back(std::make_pair((I) (e.target_node - source_count), (W) e.weight));
+        next_edges[source_id] = edge_generator->getEdge(source_id);
+    }
+
+    void siftDown(std::vector<Slot>& heap, I position) {
+        while (2 * position + 1 < heap.size()) {
+            I child = 2 * position + 1;
+            if (child + 1 < heap.size() && heap[child + 1].price < heap[child].price) {
+                child++;
+            }
+            if (heap[child].price >= heap[position].price) {
+                break;
+            }
+            std::swap(heap[child], heap[position]);
+            position = child;
+        }
+    }
+
+    /*
+     * One phase: all assignments are dropped, prices are kept, and Jacobi rounds run until every slot is taken
+     */
+    void runAuction(Cost epsilon) {
+        bidders.clear();
+        for (I j = 0; j <= facility_count; j++) {
+            for (auto& slot : slots[j]) {
+                slot.holder = FREE_SLOT;
+            }
+            if (j < facility_count) {
+                bidders.insert(bidders.end(), slots[j].size(), fillerOf(j));
+            }
+        }
+        for (I i = 0; i < source_count; i++) {
+            assigned[i] = FREE_SLOT;
+            if (node_excess[i] < 0) {
+                bidders.push_back(i);
+            }
+        }
+        std::vector<I> next_bidders;
+        while (!bidders.empty()) {
+            bids.resize(bidders.size());
+            long bidder_count = bidders.size();
+            #pragma omp parallel for schedule(static)
+            for (long k = 0; k < bidder_count; k++) {
+                bids[k] = computeBid(bidders[k], epsilon);
+            }
+            //edge generators are not thread safe
+            for (long k = 0; k < bidder_count; k++) {
+                while (bids[k].needs_edges) {
+                    addNextEdge(bidders[k]);
+                    bids[k] = computeBid(bidders[k], epsilon);
+                }
+            }
+
+            next_bidders.clear();
+            for (long k = 0; k < bidder_count; k++) {
+                I bidder = bidders[k];
+                Bid& bid = bids[k];
+                bid_count++;
+                std::vector<Slot>& heap = slots[bid.object];
+                if (bid.price <= heap[0].price) {
+                    next_bidders.push_back(bidder); //outbid by an earlier bidder in this round
+                    continue;
+                }
+                I evicted = heap[0].holder;
+                heap[0].holder = bidder;
+                heap[0].price = bid.price;
+                siftDown(heap, 0);
+                if (bidder >= 0) {
+                    assign(bidder, bid.object);
+                }
+                if (evicted != FREE_SLOT) {
+                    if (evicted >= 0) {
+                        assigned[evicted] = FREE_SLOT;
+                    }
+                    next_bidders.push_back(evicted);
+                }
+            }
+            bidders.swap(next_bidders);
+        }
+    }
+
+    void assign(I source_id, I object) {
+        assigned[source_id] = object;
+        assigned_weight[source_id] = VERY_BIG_W;
+        for (auto& edge : known_edges[source_id]) {
+            if (edge.first == object) {
+                assigned_weight[source_id] = edge.second;
+                return;
+            }
+        }
+    }
+};
+
+#endif //FCLA_AUCTIONMATCHER_H
@@ -0,0 +1,210 @@
+/*
+ * Indexed bucket queue of facilities by coverage with the interface of fHeap (see nheap.h), a max-queue of FacilityRank.
+ *
+ * Coverage is bounded by the capacity of a facility, so there is one bucket per coverage value and the top is
+ * the highest non-empty bucket. In the lazy greedy set cover coverage only decreases: a re-enqueued facility
+ * goes to a lower bucket than the one it was dequeued from, so the top bucket never gets new elements
+ * and the top index only moves down during one cover.
+ * Buckets are unordered arrays; when a bucket becomes the top it is sorted once by the rest of FacilityRank
+ * (lastUsed, then id order), so ties are broken exactly as in a heap of FacilityRank and the cover does not change.
+ */
+
+#ifndef FCLA_BUCKETQUEUE_H
+#define FCLA_BUCKETQUEUE_H
+
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#include "FacilityRank.h"
+
+template <class V, class I, class Compare = std::greater<V>>
+class BucketQueue {
+    static_assert(std::is_same<V, FacilityRank>::value, "Bucket queue supports only FacilityRank");
+    static_assert(std::is_same<Compare, std::greater<V>>::value, "Bucket queue is a max-queue only");
+public:
+    BucketQueue() {
+        top = -1;
+        count = 0;
+    }
+    ~BucketQueue() {}
+
+    void clear() {
+        softClear();
+        bucket_of.clear();
+        position_of.clear();
+    }
+
+    void reset() {
+        clear();
+    }
+
+    /*
+     * Empty the queue keeping the allocated index and buckets
+     */
+    void softClear() {
+        for (auto& bucket : buckets) {
+            for (auto& e : bucket.elems) {
+                bucket_of[e.idx] = -1;
+            }
+            bucket.elems.clear();
+            bucket.sorted = true;
+        }
+        top = -1;
+        count = 0;
+    }
+
+    inline I size() const {
+        return count;
+    }
+
+    inline bool isExisted(I idx) const {
+        return idx < bucket_of.size() && bucket_of[idx] != -1;
+    }
+
+    bool isExisted(I idx, V& value) const {
+        if (!isExisted(idx)) {
+            return false;
+        }
+        value = getVal(idx);
+        return true;
+    }
+
+    inline V getVal(I idx) const {
+        return buckets[bucket_of[idx]].elems[position_of[idx]].value;
+    }
+
+    V getTopValue() {
+        return topBucket().elems.back().value;
+    }
+
+    I getTopIdx() {
+        return topBucket().elems.back().idx;
+    }
+
+    void getTop(I& idx, V& value) {
+        elem& e = topBucket().elems.back();
+        idx = e.idx;
+        value = e.value;
+    }
+
+    void enqueue(I idx, V value) {
+        if (value.coverage < 0) {
+            throw std::logic_error("Bucket queue requires non-negative coverage");
+        }
+        if (idx >= bucket_of.size()) {
+            bucket_of.resize(idx + 1, -1);
+            position_of.resize(idx + 1, -1);
+        }
+        if (value.coverage >= buckets.size()) {
+            buckets.resize(value.coverage + 1);
+        }
+        bucket& b = buckets[value.coverage];
+        bucket_of[idx] = value.coverage;
+        position_of[idx] = b.elems.size();
+        b.elems.push_back(elem{value, idx});
+        b.sorted = b.elems.size() == 1;
+        top = std::max(top, (I) value.coverage);
+        count++;
+    }
+
+    /*
+     * Returns 0 if the queue is empty, as fHeap does
+     */
+    I dequeue(I& idx) {
+        V value;
+        return dequeue(idx, value) ? 1 : 0;
+    }
+
+    I dequeue() {
+        I idx = 0;
+        dequeue(idx);
+        return idx;
+    }
+
+    bool dequeue(I& idx, V& value) {
+        if (count == 0) {
+            return false;
+        }
+        bucket& b = topBucket();
+        idx = b.elems.back().idx;
+        value = b.elems.back().value;
+        b.elems.pop_back();
+        bucket_of[idx] = -1;
+        count--;
+        return true;
+    }
+
+    void updatequeue(I idx, V new_val) {
+        erase(idx);
+        enqueue(idx, new_val);
+    }
+
+    bool updateorenqueue(I idx, V new_val) {
+        if (isExisted(idx)) {
+            updatequeue(idx, new_val);
+            return true;
+        }
+        enqueue(idx, new_val);
+        return false;
+    }
+
+    bool remove(I idx) {
+        if (!isExisted(idx)) {
+            return false;
+        }
+        erase(idx);
+        return true;
+    }
+
+private:
+    struct elem {
+        V value;
+        I idx;
+    };
+    struct bucket {
+        std::vector<elem> elems; //the best element is the last one if sorted
+        bool sorted = true;
+    };
+
+    std::vector<bucket> buckets; //by coverage
+    std::vector<I> bucket_of; //-1 if not in the queue
+    std::vector<I> position_of;
+    I top; //no elements in buckets above
+    I count;
+
+    /*
+     * The highest non-empty bucket, sorted
+     */
+    bucket& topBucket() {
+        while (buckets[top].elems.empty()) {
+            top--;
+        }
+        bucket& b = buckets[top];
+        if (!b.sorted) {
+            std::sort(b.elems.begin(), b.elems.end(), [](const elem& a, const elem& c) { return a.value < c.value; });
+            for (I i = 0; i < b.elems.size(); i++) {
+                position_of[b.elems[i].idx] = i;
+            }
+            b.sorted = true;
+        }
+        return b;
+    }
+
+    inline void erase(I idx) {
+        bucket& b = buckets[bucket_of[idx]];
+        I position = position_of[idx];
+        if (position != b.elems.size() - 1) {
+            b.elems[position] = b.elems.back();
+            position_of[b.elems[position].idx] = position;
+            b.sorted = false;
+        }
+        b.elems.pop_back();
+        bucket_of[idx] = -1;
+        count--;
+    }
+};
+
+#endif //FCLA_BUCKETQUEUE_H
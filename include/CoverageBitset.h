@@ -0,0 +1,55 @@
+/*
+ * Bitmap kernels of the greedy set cover (see FacilityChooser::pickAnotherFacility).
+ *
+ * Customers matched with a dense facility are stored as a bitmap over the range of 64-bit words
+ * that contains them, covered customers are one bitmap for all customers. The marginal coverage of
+ * a facility is then popcount(facility & ~covered) over its words instead of a check per customer.
+ * The loop is marked for omp simd, so it is vectorized where the target has a vector popcount.
+ */
+
+#ifndef FCLA_COVERAGEBITSET_H
+#define FCLA_COVERAGEBITSET_H
+
+#include <vector>
+#include <cstdint>
+
+#define COVERAGE_WORD_BITS 64
+
+inline long coverage_word(long customer) {
+    return customer / COVERAGE_WORD_BITS;
+}
+
+inline uint64_t coverage_bit(long customer) {
+    return 1ULL << (customer % COVERAGE_WORD_BITS);
+}
+
+/*
+ * Remove covered customers from the bitmap of a facility and return the number of the rest
+ * <covered> points to the word of the covered bitmap that corresponds to the first word of <bits>
+ */
+inline long subtract_covered_bits(uint64_t* bits, const uint64_t* covered, long words) {
+    long count = 0;
+    #pragma omp simd reduction(+:count)
+    for (long w = 0; w < words; w++) {
+        uint64_t uncovered = bits[w] & ~covered[w];
+        bits[w] = uncovered;
+        count += __builtin_popcountll(uncovered);
+    }
+    return count;
+}
+
+/*
+ * Call visit(customer) for every customer of a bitmap that starts at word <first_word>
+ */
+template<typename V>
+inline void for_each_bit(const uint64_t* bits, long first_word, long words, V visit) {
+    for (long w = 0; w < words; w++) {
+        uint64_t word = bits[w];
+        while (word) {
+            visit((first_word + w) * COVERAGE_WORD_BITS + __builtin_ctzll(word));
+            word &= word - 1;
+        }
+    }
+}
+
+#endif //FCLA_COVERAGEBITSET_H
@@ -0,0 +1,214 @@
+/*
+ * Indexed d-ary heap with a compile-time comparator, a replacement of fHeap (see nheap.h) with the same interface.
+ *
+ * Elements are moved into a hole instead of being swapped, so every level of sift-up and sift-down
+ * costs one copy of an element and one update of its position. With D = 2 and std::less the order of
+ * elements and the tie-breaking are the same as in fHeap with sign 0, std::greater corresponds to sign 1.
+ */
+
+#ifndef FCLA_DARYHEAP_H
+#define FCLA_DARYHEAP_H
+
+#include <vector>
+#include <functional>
+#include <algorithm>
+
+template <class V, class I, unsigned D = 4, class Compare = std::less<V>>
+class DaryHeap {
+public:
+    struct elem {
+        V value;
+        I idx;
+    };
+
+    DaryHeap() {}
+    ~DaryHeap() {}
+
+    void clear() {
+        heap.clear();
+        order.clear();
+    }
+
+    void reset() {
+        clear();
+    }
+
+    /*
+     * Empty the heap keeping the allocated index, the cost is proportional to the heap size
+     */
+    void softClear() {
+        for (auto& e : heap) {
+            order[e.idx] = -1;
+        }
+        heap.clear();
+    }
+
+    inline I size() const {
+        return heap.size();
+    }
+
+    inline bool isExisted(I idx) const {
+        return idx < order.size() && order[idx] != -1;
+    }
+
+    bool isExisted(I idx, V& value) const {
+        if (!isExisted(idx)) {
+            return false;
+        }
+        value = heap[order[idx]].value;
+        return true;
+    }
+
+    inline V getVal(I idx) const {
+        return heap[order[idx]].value;
+    }
+
+    inline V getTopValue() const {
+        return heap[0].value;
+    }
+
+    inline I getTopIdx() const {
+        return heap[0].idx;
+    }
+
+    void getTop(I& idx, V& value) const {
+        idx = heap[0].idx;
+        value = heap[0].value;
+    }
+
+    void enqueue(I idx, V value) {
+        if (idx >= order.size()) {
+            order.resize(idx + 1, -1);
+        }
+        heap.push_back(elem());
+        siftUp(heap.size() - 1, elem{value, idx});
+    }
+
+    /*
+     * Returns 0 if the heap is empty, as fHeap does
+     */
+    I dequeue(I& idx) {
+        if (heap.empty()) {
+            return 0;
+        }
+        idx = heap[0].idx;
+        popTop();
+        return 1;
+    }
+
+    I dequeue() {
+        if (heap.empty()) {
+            return 0;
+        }
+        I idx = heap[0].idx;
+        popTop();
+        return idx;
+    }
+
+    bool dequeue(I& idx, V& value) {
+        if (heap.empty()) {
+            return false;
+        }
+        idx = heap[0].idx;
+        value = heap[0].value;
+        popTop();
+        return true;
+    }
+
+    void updatequeue(I idx, V new_val) {
+        I position = order[idx];
+        if (compare(new_val, heap[position].value)) {
+            siftUp(position, elem{new_val, idx});
+        } else {
+            siftDown(position, elem{new_val, idx});
+        }
+    }
+
+    bool updateorenqueue(I idx, V new_val) {
+        if (isExisted(idx)) {
+            updatequeue(idx, new_val);
+            return true;
+        }
+        enqueue(idx, new_val);
+        return false;
+    }
+
+    bool remove(I idx) {
+        if (!isExisted(idx)) {
+            return false;
+        }
+        I position = order[idx];
+        order[idx] = -1;
+        elem last = heap.back();
+        heap.pop_back();
+        if (position < heap.size()) {
+            if (compare(last.value, heap[position].value)) {
+                siftUp(position, last);
+            } else {
+                siftDown(position, last);
+            }
+        }
+        return true;
+    }
+
+private:
+    std::vector<elem> heap;
+    std::vector<I> order; //position of an element in the heap by its idx, -1 if it is not in the heap
+    Compare compare;
+
+    void popTop() {
+        order[heap[0].idx] = -1;
+        elem last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) {
+            siftDown(0, last);
+        }
+    }
+
+    /*
+     * Move the hole at <position> up until <e> fits into it
+     */
+    inline void siftUp(I position, const elem& e) {
+        while (position > 0) {
+            I parent = (position - 1) / (I) D;
+            if (!compare(e.value, heap[parent].value)) {
+                break;
+            }
+            heap[position] = heap[parent];
+            order[heap[position].idx] = position;
+            position = parent;
+        }
+        heap[position] = e;
+        order[e.idx] = position;
+    }
+
+    /*
+     * Move the hole at <position> down until <e> fits into it, among equal children the last one is taken
+     */
+    inline void siftDown(I position, const elem& e) {
+        I count = heap.size();
+        while (true) {
+            I first = position * (I) D + 1;
+            if (first >= count) {
+                break;
+            }
+            I last = std::min(first + (I) D, count);
+            I best = first;
+            for (I child = first + 1; child < last; child++) {
+                if (!compare(heap[best].value, heap[child].value)) {
+                    best = child;
+                }
+            }
+            if (!compare(heap[best].value, e.value)) {
+                break;
+            }
+            heap[position] = heap[best];
+            order[heap[position].idx] = position;
+            position = best;
+        }
+        heap[position] = e;
+        order[e.idx] = position;
+    }
+};
+
+#endif //FCLA_DARYHEAP_H
@@ -12,6 +12,14 @@
 #include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <string>
+#include <cstdlib>
+#include <cstdint>
+#include <stdexcept>
+
+#define EDGE_FILE_MAGIC "FCLAEDGE" //first bytes of a binary edge file
+#define EDGE_FILE_MAGIC_SIZE 8
+#define EDGE_RECORD_FIELDS 5 //exists, target_node, capacity, source_node, weight
 
 typedef struct {
     bool exists; //flag if there is any new edge to be added
@@ -27,6 +35,37 @@ public:
     long n; //number of vertices for generation (left side)
     long m; //number of target vertices
     newEdges edgeMemory;
+    newEdges nearest_edges; //the first edge of every source, edges of a source are generated in increasing weight
+
+    /*
+     * Save a generated edge, the first one of a source is its nearest target
+     */
+    void rememberEdge(const newEdge& e) {
+        edgeMemory.push_back(e);
+        if (!e.exists) {
+            return;
+        }
+        if (e.source_node >= nearest_edges.size()) {
+            newEdge none;
+            none.exists = false;
+            nearest_edges.resize(e.source_node + 1, none);
+        }
+        if (!nearest_edges[e.source_node].exists) {
+            nearest_edges[e.source_node] = e;
+        }
+    }
+
+    /*
+     * The nearest target of a source among generated edges, does not exist if nothing is generated yet
+     */
+    virtual newEdge getNearestEdge(long vid) {
+        if (vid < nearest_edges.size()) {
+            return nearest_edges[vid];
+        }
+        newEdge none;
+        none.exists = false;
+        return none;
+    }
 
     void save(std::string filename) {
         std::ofstream f;
@@ -41,6 +80,41 @@ public:
         f.close();
     }
 
+    /*
+     * Same records as in save(), but stored as fixed-width integers after a magic header and a record count
+     */
+    void saveBinary(std::string filename) {
+        std::ofstream f;
+        f.open(filename, std::ofstream::out | std::ofstream::binary);
+        f.write(EDGE_FILE_MAGIC, EDGE_FILE_MAGIC_SIZE);
+        int64_t count = edgeMemory.size();
+        f.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        std::vector<int64_t> records;
+        records.reserve(edgeMemory.size() * EDGE_RECORD_FIELDS);
+        for (long i = 0; i < edgeMemory.size(); i++) {
+            records.push_back(edgeMemory[i].exists);
+            records.push_back(edgeMemory[i].target_node);
+            records.push_back(edgeMemory[i].capacity);
+            records.push_back(edgeMemory[i].source_node);
+            records.push_back(edgeMemory[i].weight);
+        }
+        f.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(int64_t));
+        f.close();
+    }
+
+    /*
+     * Inverse of a record written by save() or saveBinary()
+     */
+    static newEdge makeEdge(const long record[]) {
+        newEdge e;
+        e.exists = record[0];
+        e.target_node = record[1];
+        e.capacity = record[2];
+        e.source_node = record[3];
+        e.weight = record[4];
+        return e;
+    }
+
     void makeComplete() {
         for (long i = 0; i < this->n; i++) {
             while (!isComplete(i)) {
@@ -82,61 +156,154 @@ public:
         return e;
     }
     virtual void reset() {}
+
+    /*
+     * Generate edges of a source from another place again, e.g. a customer moved to another node of a network
+     */
+    virtual void relocateSource(long vid, long node) {
+        throw std::logic_error("Edge generator cannot relocate sources");
+    }
 };
 
 /*
- * Loads file with edgeMemory (edge queue) and throws all edges sequentially
+ * Loads file with edgeMemory (edge queue) and throws edges of each source sequentially
+ *
+ * Both formats written by EdgeGenerator are accepted: csv from save() and binary from saveBinary().
+ * Edges are bucketed per source (counting sort), so that each getEdge call only moves a cursor of that source.
  */
 class LoadedEdgeGenerator : public EdgeGenerator {
 public:
-    newEdges edgeQueue;
+    newEdges edgeQueue; //edges of source s are edgeQueue[queue_offset[s]..queue_offset[s+1]) in non-decreasing weight
+    std::vector<long> queue_offset;
+    std::vector<long> next_edge; //cursor per source, index of the next edge in edgeQueue
+
     LoadedEdgeGenerator(std::string filename) {
         this->n = 0;
         this->m = 0;
         this->load(filename);
     }
     ~LoadedEdgeGenerator() {}
+
     void load(std::string filename) {
         edgeMemory.clear();
-        std::ifstream f(filename);
+        std::ifstream f(filename, std::ifstream::in | std::ifstream::binary);
         if (!f.is_open())
             throw "File does not exist";
-        std::string line;
-        while ( getline (f,line) ) {
-            if (line == "")
+        char magic[EDGE_FILE_MAGIC_SIZE];
+        if (f.read(magic, EDGE_FILE_MAGIC_SIZE) && std::string(magic, EDGE_FILE_MAGIC_SIZE) == EDGE_FILE_MAGIC) {
+            loadBinary(f);
+        } else {
+            f.clear();
+            f.seekg(0, std::ios::beg);
+            loadCSV(f);
+        }
+        f.close();
+        for (long i = 0; i < edgeMemory.size(); i++) {
+            this->n = std::max(n, (long)edgeMemory[i].source_node);
+            this->m = std::max(m, (long)edgeMemory[i].target_node);
+        }
+        buildQueue();
+    }
+
+    void loadCSV(std::ifstream& f) {
+        //read the whole file at once and parse numbers in place, stringstream per line is too slow for large files
+        f.seekg(0, std::ios::end);
+        std::string buffer(f.tellg(), '\0');
+        f.seekg(0, std::ios::beg);
+        f.read(&buffer[0], buffer.size());
+
+        const char* it = buffer.c_str();
+        const char* end = it + buffer.size();
+        long record[EDGE_RECORD_FIELDS];
+        while (it < end) {
+            if (*it == '\n' || *it == '\r')
                 throw "Empty file with Edges";
-            std::vector<long> vect;
-            std::stringstream ss(line);
-            long i;
-            while (ss >> i)
-            {
-                vect.push_back(i);
-
-                if (ss.peek() == ',')
-                    ss.ignore();
+            for (int i = 0; i < EDGE_RECORD_FIELDS; i++) {
+                char* next;
+                record[i] = strtol(it, &next, 10);
+                if (next == it)
+                    throw "Wrong format of file with Edges";
+                it = next;
+                if (i < EDGE_RECORD_FIELDS - 1) {
+                    if (*it != ',')
+                        throw "Wrong format of file with Edges";
+                    it++;
+                }
             }
-            newEdge e;
-            e.exists = vect[0];
-            e.target_node = vect[1];
-            e.capacity = vect[2];
-            e.source_node = vect[3];
-            e.weight = vect[4];
-            edgeMemory.push_back(e);
-            this->n = std::max(n, (long)e.source_node);
-            this->m = std::max(m, (long)e.target_node);
+            while (it < end && *it != '\n') it++; //skip line ending
+            it++;
+            edgeMemory.push_back(makeEdge(record));
         }
-        f.close();
-        edgeQueue = edgeMemory;
     }
 
-    newEdge getEdge(long vid) override {
-        for (long i = 0; i < this->edgeQueue.size(); i++) {
-            if (edgeQueue[i].source_node == vid) {
-                newEdge e = edgeQueue[i];
-                edgeQueue.erase(edgeQueue.begin() + i);
-                return e;
+    void loadBinary(std::ifstream& f) {
+        int64_t count;
+        if (!f.read(reinterpret_cast<char*>(&count), sizeof(count)))
+            throw "Wrong format of file with Edges";
+        //the count of a truncated or corrupted file must not size the allocation
+        std::streamoff records_begin = f.tellg();
+        f.seekg(0, std::ios::end);
+        std::streamoff records_size = f.tellg() - records_begin;
+        f.seekg(records_begin, std::ios::beg);
+        if (count < 0 || count > records_size / (std::streamoff) (EDGE_RECORD_FIELDS * sizeof(int64_t)))
+            throw "Wrong format of file with Edges";
+        std::vector<int64_t> records(count * EDGE_RECORD_FIELDS);
+        if (!f.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(int64_t)))
+            throw "Wrong format of file with Edges";
+        edgeMemory.reserve(count);
+        long record[EDGE_RECORD_FIELDS];
+        for (long i = 0; i < count; i++) {
+            for (int j = 0; j < EDGE_RECORD_FIELDS; j++) {
+                record[j] = records[i * EDGE_RECORD_FIELDS + j];
+            }
+            edgeMemory.push_back(makeEdge(record));
+        }
+    }
+
+    /*
+     * Bucket edges by source preserving the order of the file.
+     * Non-existing edges are not replayed: getEdge returns a non-existing edge anyway when the bucket is over.
+     */
+    void buildQueue() {
+        long source_count = 0;
+        for (long i = 0; i < edgeMemory.size(); i++) {
+            if (edgeMemory[i].exists) {
+                source_count = std::max(source_count, (long)edgeMemory[i].source_node + 1);
+            }
+        }
+        queue_offset.assign(source_count + 1, 0);
+        for (long i = 0; i < edgeMemory.size(); i++) {
+            if (edgeMemory[i].exists) {
+                queue_offset[edgeMemory[i].source_node + 1]++;
+            }
+        }
+        for (long i = 0; i < source_count; i++) {
+            queue_offset[i + 1] += queue_offset[i];
+        }
+        edgeQueue.resize(queue_offset[source_count]);
+        std::vector<long> position(queue_offset.begin(), queue_offset.end() - 1);
+        for (long i = 0; i < edgeMemory.size(); i++) {
+            if (edgeMemory[i].exists) {
+                edgeQueue[position[edgeMemory[i].source_node]++] = edgeMemory[i];
             }
         }
+
+        //generators write edges of each source in non-decreasing weight, sort only hand-made files
+        auto by_weight = [](const newEdge& a, const newEdge& b) { return a.weight < b.weight; };
+        for (long i = 0; i < source_count; i++) {
+            auto first = edgeQueue.begin() + queue_offset[i];
+            auto last = edgeQueue.begin() + queue_offset[i + 1];
+            if (!std::is_sorted(first, last, by_weight)) {
+                std::stable_sort(first, last, by_weight);
+            }
+        }
+        next_edge.assign(queue_offset.begin(), queue_offset.end() - 1);
+    }
+
+    newEdge getEdge(long vid) override {
+        if (vid >= 0 && vid < next_edge.size() && next_edge[vid] < queue_offset[vid + 1]) {
+            return edgeQueue[next_edge[vid]++];
+        }
         newEdge new_edge;
         new_edge.exists = false;
         return new_edge;
@@ -146,20 +313,38 @@ public:
         return true; //a node for the loaded graph is always assumed to contain all outgoing edges
     }
 
+    newEdge getNearestEdge(long vid) override {
+        if (vid >= 0 && vid < next_edge.size() && queue_offset[vid] < queue_offset[vid + 1]) {
+            return edgeQueue[queue_offset[vid]];
+        }
+        newEdge none;
+        none.exists = false;
+        return none;
+    }
+
     void reset() override {
-        edgeQueue = edgeMemory;
+        next_edge.assign(queue_offset.begin(), queue_offset.end() - 1);
     }
 };
 
 /*
  * Class that provides a callback function that incrementally throws new edges for each node in weight increasing order
+ *
+ * Neighbors of a node are not materialized: the k-th neighbor is the k-th element of a per-node permutation of
+ * target nodes, given by a Feistel network keyed by the seed and the node. Weights are derived from the same key,
+ * so the edges of a node depend only on the seed, not on the order in which nodes are asked for edges.
  */
 class RandomEdgeGenerator : public EdgeGenerator {
 public:
+    const int FEISTEL_ROUNDS = 4;
+    const long MAX_WEIGHT_STEP = 100;
     std::vector<long> prev_weights;
-    std::vector<std::vector<long>> neighbors;
-    std::vector<long> next_neighbor_id;
-    igraph_rng_t rng;
+    std::vector<long> next_neighbor_id; //number of neighbors thrown per node
+    std::vector<long> next_position; //position in the permutation of targets per node
+    long target_start_vid;
+    uint64_t seed;
+    unsigned half_bits; //permutation domain is [0, 4^half_bits), covering [0, m)
+    uint64_t half_mask;
 
     /*
      * Create a generator for n nodes
@@ -167,29 +352,54 @@ public:
      * Specify a range for target nodes and capacity of target nodes
      * Every edge will have a capacity equal to capacity of a target node
      */
-    RandomEdgeGenerator(long n, long target_start_vid, long target_vcount, long target_capacity) {
+    RandomEdgeGenerator(long n, long target_start_vid, long target_vcount, long target_capacity, uint64_t seed = 0) {
         this->n = n;
         this->m = target_vcount;
-        prev_weights.resize(n,0);
+        this->target_start_vid = target_start_vid;
+        this->seed = seed;
+        half_bits = 0;
+        while ((1ULL << (2 * half_bits)) < (uint64_t)target_vcount) {
+            half_bits++;
+        }
+        half_mask = (1ULL << half_bits) - 1;
+        reset();
+    }
 
-        igraph_rng_init(&rng, &igraph_rngtype_mt19937);
-        igraph_rng_seed(&rng, time(NULL));
+    ~RandomEdgeGenerator() {}
 
-        for (long i = 0; i < n; i++) {
-            std::vector<long> neighbors;
-            for (long j = target_start_vid; j < target_start_vid + target_vcount; j++) {
-                if (i != j)
-                    neighbors.push_back(j);
-            }
-            std::random_shuffle(neighbors.begin(), neighbors.end());
-            this->neighbors.push_back(neighbors);
-        }
+    /*
+     * splitmix64 finalizer
+     */
+    static inline uint64_t mix(uint64_t x) {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
 
-        next_neighbor_id.resize(n, 0);
+    /*
+     * Bijection of [0, m) for a node: balanced Feistel network over [0, 4^half_bits),
+     * values outside of [0, m) are walked along their cycle until they fall inside
+     */
+    long permute(long vid, long position) {
+        uint64_t key = mix(seed ^ mix((uint64_t)vid));
+        uint64_t x = position;
+        do {
+            uint64_t left = x >> half_bits;
+            uint64_t right = x & half_mask;
+            for (int round = 0; round < FEISTEL_ROUNDS; round++) {
+                uint64_t next = left ^ (mix(mix(key + round) ^ right) & half_mask);
+                left = right;
+                right = next;
+            }
+            x = (left << half_bits) | right;
+        } while (x >= (uint64_t)this->m);
+        return x;
     }
 
-    ~RandomEdgeGenerator() {
-        igraph_rng_destroy(&rng);
+    inline long neighborCount(long vid) {
+        //a node is never connected to itself
+        return this->m - (vid >= target_start_vid && vid < target_start_vid + this->m);
     }
 
     /*
@@ -202,12 +412,18 @@ public:
     newEdge getEdge(long vid) override {
         newEdge new_edge;
         if (vid < n && !isComplete(vid)) {
+            long target_node = target_start_vid + permute(vid, next_position[vid]++);
+            if (target_node == vid) {
+                target_node = target_start_vid + permute(vid, next_position[vid]++);
+            }
+            uint64_t weight_key = mix(seed ^ mix((uint64_t)vid) ^ mix(~(uint64_t)next_neighbor_id[vid]));
+            next_neighbor_id[vid]++;
             new_edge.source_node = vid;
-            new_edge.weight = igraph_rng_get_integer(&rng, prev_weights[vid], prev_weights[vid]+100);
-            new_edge.target_node = neighbors[vid][next_neighbor_id[vid]++];
+            new_edge.weight = prev_weights[vid] + (long)(weight_key % (MAX_WEIGHT_STEP + 1));
+            new_edge.target_node = target_node;
             new_edge.exists = true;
             new_edge.capacity = 1;
-            edgeMemory.push_back(new_edge);
+            rememberEdge(new_edge);
             prev_weights[vid] = new_edge.weight;
         } else {
             new_edge.exists = false;
@@ -216,13 +432,15 @@ public:
     }
 
     bool isComplete(long vid) override {
-        return next_neighbor_id[vid] == neighbors[vid].size();
+        return next_neighbor_id[vid] == neighborCount(vid);
     }
 
     void reset() override {
         edgeMemory.clear();
-        prev_weights.resize(n,0);
-        next_neighbor_id.resize(n, 0);
+        nearest_edges.clear();
+        prev_weights.assign(n, 0);
+        next_neighbor_id.assign(n, 0);
+        next_position.assign(n, 0);
     }
 };
 
@@ -10,16 +10,17 @@
 #include <limits>
 #include "EdgeGenerator.h"
 #include "Network.h"
-#include "nheap.h"
+#include "HeapPolicy.h"
 
-template<typename I, typename W>
+template<typename I, typename W, typename H = GeneratorHeapPolicy>
 class ExploringEdgeGenerator : public EdgeGenerator {
 public:
+    typedef typename H::template heap<W,I> DijkstraHeap;
     const W INF_W = std::numeric_limits<W>::max();
     //provide dijkstra in various graph frameworks
     igraph_t* graph;// do not init or destroy
     I node_count_in_network; //note that there is <n> inherited for number of customers
-    std::vector<fHeap<W,I>> dheaps; //dijsktra heaps for each source node
+    std::vector<DijkstraHeap> dheaps; //dijsktra heaps for each source node
     std::vector<I> source_node_index; //index of customers: source_node_index[id] = vid in graph of a customer #id
     std::vector<W> weights;
 
@@ -31,7 +32,7 @@ public:
     std::vector<std::vector<bool>> visited;
 
     void updateNeighbor(I customer_id, I target, W cost) {
-        fHeap<W,I>& dheap = dheaps[customer_id];
+        DijkstraHeap& dheap = dheaps[customer_id];
         if (dheap.isExisted(target)) {
             if (dheap.getVal(target) > cost) {
                 dheap.updatequeue(target, cost);
@@ -66,7 +67,7 @@ public:
         dheaps.clear();
         //n goes for number of customers
         for (I i = 0; i < n; i++) {
-            fHeap<W,I> heap;
+            DijkstraHeap heap;
             heap.enqueue(source_node_index[i],0); //first output edge will be a loop edge
             dheaps.push_back(heap);
 
@@ -75,14 +76,19 @@ public:
         }
     }
 
-    ExploringEdgeGenerator(Network& network) {
+    ExploringEdgeGenerator(Network& network) : ExploringEdgeGenerator(network, network.source_indexes) {}
+
+    /*
+     * Customers at other nodes than the ones of the network, e.g. after dynamic updates of a facility chooser
+     */
+    ExploringEdgeGenerator(Network& network, std::vector<long>& source_indexes) {
         //init dijkstra heaps
         node_count_in_network = igraph_vcount(&network.graph);
-        this->n = network.source_indexes.size();
+        this->n = source_indexes.size();
         this->m = node_count_in_network;
-        this->source_node_index = network.source_indexes;
+        this->source_node_index.assign(source_indexes.begin(), source_indexes.end());
         this->graph = &network.graph;
-        this->weights = network.weights;
+        this->weights.assign(network.weights.begin(), network.weights.end());
         init_dijkstra();
     }
 
@@ -132,7 +138,7 @@ public:
             //for target node we must return ID of a facility, i.e.
             e.target_node = this->n + next_vid;
             e.weight = shortest_dist; //shortest distance between
-            edgeMemory.push_back(e);
+            rememberEdge(e);
         }
 
         return e;
@@ -142,6 +148,18 @@ public:
     void reset() override {
         init_dijkstra();
     }
+
+    //restart dijkstra of a customer from another node of the network
+    void relocateSource(long vid, long node) override {
+        source_node_index[vid] = node;
+        DijkstraHeap heap;
+        heap.enqueue(node, 0);
+        dheaps[vid] = heap;
+        visited[vid].assign(node_count_in_network, false);
+        if (vid < nearest_edges.size()) {
+            nearest_edges[vid].exists = false;
+        }
+    }
 };
 
 #endif //FCLA_EXPLORINGEDGEGENERATOR_H
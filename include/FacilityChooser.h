@@ -11,24 +11,50 @@
 #ifndef FCLA_FACILITYCHOOSER_H
 #define FCLA_FACILITYCHOOSER_H
 
-#include <forward_list>
 #include <fstream>
 #include <stack>
+#include <atomic>
+#include <limits>
+#include <chrono>
 #include "nheap.h"
+#include "HeapPolicy.h"
 #include "ExploringEdgeGenerator.h"
 #include "TargetExploringEdgeGenerator.h"
+#include "SharedExploration.h"
 #include "Matcher.h"
+#include "AuctionMatcher.h"
+#include "PartitionedMatcher.h"
 #include "Network.h"
 #include "Logger.h"
 #include "helpers.h"
 #include "FacilityRank.h"
+#include "IterationArena.h"
+#include "CoverageBitset.h"
 #include "exceptions.h"
 
-class FacilityChooser : public Matcher<long,long,long> {
+/*
+ * Template types stand for < weight/potentials/cost type, node/edge index type > of the matching,
+ * see FacilityChooser and FacilityChooser32 below
+ */
+template<typename W, typename I>
+class BasicFacilityChooser : public Matcher<long,W,I> {
 public:
+    typedef typename Matcher<long,W,I>::EdgeIterator EdgeIterator;
     enum State {
         UNINITIALIZED, NOT_LOCATED, LOCATED, INFEASIBLE, ERROR
     };
+    /*
+     * Customers matched with a facility that are not covered yet, stored in the iteration arena.
+     * Loaded when the set cover dequeues the facility for the first time in an iteration, size is -1 before.
+     * Dense facilities keep a bitmap of words [first_word, first_word + words) instead of the array, see loadMatchedCustomers
+     */
+    struct MatchedCustomers {
+        long* customers;
+        uint64_t* bits; //null for the array
+        long first_word;
+        long words;
+        long size;
+    };
     long max_coverage;
     std::vector<long> result;
     long totalCost;
@@ -38,19 +64,55 @@ public:
     std::vector<long> source_indexes;
     std::map<long, long> source_reverse_index;
     std::vector<long> target_indexes;
+    std::vector<long> target_reverse_index; //facility id of a network node, -1 if not a potential facility
     std::vector<long> target_capacities;
     State state = UNINITIALIZED;
     std::vector<long> customer_antirank; //number of facilities a customer is
     std::vector<long> last_used;
-    double alpha;
+    double alpha; //exploring pace, 0 - demands grow by one per iteration, see getDemandIncrement
+    bool pace_backoff = false; //double the pace while the cover does not grow, halve it back when it grows
+    double pace;
+    long previous_covered;
     long capacity_iteration;//iteration ID for WMA, utilized in last_used for potential facilities
     long total_covered;
 
+    //anytime WMA: stop at a budget and return the best of the covers evaluated on the way, see locateFacilities
+    double time_budget = 0; //seconds of wall time for WMA, 0 - unlimited
+    long iteration_budget = 0; //WMA iterations, 0 - unlimited
+    long anytime_period = 0; //evaluate the partial cover every that many iterations, 0 - only with a budget, see getAnytimePeriod
+    std::vector<long> best_result;
+    long best_cost;
+    std::vector<long> best_excess; //free capacities of the assignment to the best cover
+    bool result_evaluated = false; //the result is the best cover, its cost is not computed again, see calculateResult
+    std::chrono::steady_clock::time_point wma_start;
+    long wma_first_iteration;
+
+    std::vector<int> complete_sources; //customers with all reachable facilities explored, not increased by WMA
+    long removed_customers = 0; //customers removed by dynamic updates, they count as covered, see removeCustomer
+    std::vector<long> free_customers; //slots of removed customers for addCustomer, may hold slots taken again
+
+    //structures of the set cover kept between WMA iterations and updated by changes of the matching, see findSetCover
+    IterationArena iteration_arena;
+    std::vector<MatchedCustomers> matching;
+    typedef CoverageHeapPolicy::heap<FacilityRank,long,std::greater<FacilityRank>> CoverageHeap; //decreasing order
+    CoverageHeap coverage_heap; //rank of every facility by its matched customers and last_used between iterations
+    bool coverage_ready = false;
+    std::vector<long> covered; //number of chosen facilities that cover a customer
+    std::vector<long> covered_customers; //customers with nonzero covered
+    std::vector<uint64_t> covered_bits; //bitmap of nonzero covered
+    long bitset_min_density = 4; //matched customers per 64-bit word to store a facility as a bitmap, 0 - never
+    double parallel_cover_epsilon = 0; //0 - sequential lazy greedy, otherwise gain buckets of the parallel one, see parallelGreedySetCover
+    std::vector<std::atomic<long>> customer_claims; //best facility of a round that wants a customer, see parallelGreedySetCover
+    std::vector<long> touched_facilities; //bigraph nodes of facilities dequeued by the set cover in this iteration
+    std::vector<I> changed_nodes;
+
     bool uniform_capacities;
     bool partially_uniform; //used to calculate objective for uniform, but result for non-uniform
     bool all_nodes_available;
 
     int objective_matching = 1; //if objective is calculated as SIA
+    bool auction_objective = false; //if objective is calculated with AuctionMatcher instead of SIA
+    long objective_parts = 0; //if objective is calculated with PartitionedMatcher in that many parts, needs coordinates
 
     /*
      * lambda is a parameter that states when to terminate the heap exploration
@@ -58,18 +120,18 @@ public:
      */
     long lambda;
 
-    FacilityChooser() {}; //for testing
+    BasicFacilityChooser() {}; //for testing
 
     /*
      * Check feasibility by number of components
      */
     void check_feasibility() {
-        igraph_t* g = &(network->graph);
+        igraph_t* g = &(this->network->graph);
         igraph_integer_t components;
         igraph_vector_t membership;
         igraph_vector_init(&membership,0);
         igraph_clusters(g, &membership, 0, &components, IGRAPH_WEAK);
-        logger->add("number of components", components);
+        this->logger->add("number of components", components);
         std::vector<long> customers_sum(components,0);
         for (long i = 0; i < this->source_count; i++) {
             customers_sum[VECTOR(membership)[this->source_indexes[i]]]++;
@@ -85,7 +147,7 @@ public:
             throw infeasible_solution;
         }
 
-        if ((this->uniform_capacities) && (this->required_facilities * this->facility_capacity < source_count)) {
+        if ((this->uniform_capacities) && (this->required_facilities * this->facility_capacity < this->source_count)) {
             throw infeasible_solution;
         }
         //@todo add check of facility_indexes
@@ -96,13 +158,14 @@ public:
      * 1. customers (sources). Number of customers equal to size of source_node_index array
      * 2. services (targets, potential facility locations). Number of them is equal to size of a network
      */
-    FacilityChooser(Network& network,
-                    long facilities_to_locate,
-                    long facility_capacity,
-                    Logger* logger,
-                    long lambda = 0,
-                    double alpha = 1,
-                    bool partially_uniform = false) {
+    BasicFacilityChooser(Network& network,
+                         long facilities_to_locate,
+                         long facility_capacity,
+                         Logger* logger,
+                         long lambda = 0,
+                         double alpha = 0,
+                         bool partially_uniform = false,
+                         SharedExploration* exploration = nullptr) {
         logger->start2("fcla initialization");
         this->network = &network;
         this->exp_id = network.id;
@@ -113,8 +176,11 @@ public:
         this->facility_capacity = facility_capacity;
         this->logger = logger;
         this->alpha = alpha;
+        this->pace = 1;
+        this->previous_covered = -1;
         this->required_facilities = facilities_to_locate;
         this->lambda = lambda;
+        this->capacity_iteration = 0;
         this->state = NOT_LOCATED;
         this->partially_uniform = partially_uniform; //false default
 
@@ -125,38 +191,56 @@ public:
         logger->add("number of facilities", facilities_to_locate);
         logger->add("capacity of facilities", facility_capacity);
         logger->add("lambda", lambda);
+        logger->add("alpha", alpha);
 	    logger->add("uniform capacities", this->uniform_capacities);
 
-        //create generator anyway
-        if (this->all_nodes_available) {
-            this->edge_generator = new ExploringEdgeGenerator<long, long>(network);
+        if (!this->all_nodes_available) {
+            this->target_reverse_index.resize(igraph_vcount(&network.graph), -1);
+            for (long i = 0; i < this->target_indexes.size(); i++) {
+                this->target_reverse_index[this->target_indexes[i]] = i;
+            }
+        }
+
+        //create generator anyway, or read edges explored together with other choosers
+        if (exploration != nullptr) {
+            this->edge_generator = new SharedEdgeGenerator(exploration);
         } else {
-            this->edge_generator = new TargetExploringEdgeGenerator<long, long>(network, network.target_indexes);
+            this->edge_generator = createEdgeGenerator(network);
         }
-        graph_size = edge_generator->n + edge_generator->m + 1;
-        this->last_used.resize(edge_generator->m, -1);
+        this->graph_size = this->edge_generator->n + this->edge_generator->m + 1;
+        this->last_used.resize(this->edge_generator->m, -1);
         this->customer_antirank.clear();
-        this->customer_antirank.resize(source_count);
+        this->customer_antirank.resize(this->source_count);
         this->build_source_reverse_index();
 
-        logger->add("bipartite graph size", graph_size);
+        logger->add("bipartite graph size", this->graph_size);
 
         this->node_excess = this->get_node_excess();
         this->full_node_excess = this->get_node_excess();
 
         //reset variables of the matching algorithm
-        reset();
+        this->reset();
         logger->finish("fcla initialization");
     }
 
-    ~FacilityChooser() {
+    ~BasicFacilityChooser() {
         delete this->edge_generator;
     }
 
+    /*
+     * Generator of edges from customers to their nearest potential facilities in the network
+     */
+    static EdgeGenerator* createEdgeGenerator(Network& network) {
+        if (network.target_indexes.size() == 0) {
+            return new ExploringEdgeGenerator<I,W>(network);
+        }
+        return new TargetExploringEdgeGenerator<I,W>(network, network.target_indexes);
+    }
+
     std::vector<long> get_node_excess() {
         std::vector<long> node_excess(this->graph_size, -1);
         if (this->uniform_capacities || this->partially_uniform) {
-            for (long i = this->network->source_indexes.size(); i < graph_size; i++) {
+            for (long i = this->network->source_indexes.size(); i < this->graph_size; i++) {
                 node_excess[i] = facility_capacity;
             }
         } else {
@@ -179,15 +263,15 @@ public:
         /*
          * condition to terminate set cover when a new target is selected (outdated)
          */
-        return ((result.size() > this->required_facilities) && ((double)(source_count - this->total_covered)/(double)source_count > 0.1)) ||
-               ((result.size() > this->required_facilities + lambda) && ((double)(source_count - this->total_covered)/(double)source_count <= 0.1));
+        return ((result.size() > this->required_facilities) && ((double)(this->source_count - this->total_covered)/(double)this->source_count > 0.1)) ||
+               ((result.size() > this->required_facilities + lambda) && ((double)(this->source_count - this->total_covered)/(double)this->source_count <= 0.1));
     }
 
     bool if_covered_is_enough(long matching_count) {
         /*
          * another condition to terminate set cover when a new target is selected (outdated, depends on lambda)
          */
-        return (matching_count * (this->required_facilities - this->result.size() + lambda) < source_count - this->total_covered);
+        return (matching_count * (this->required_facilities - this->result.size() + lambda) < this->source_count - this->total_covered);
     }
 
 
@@ -195,72 +279,151 @@ public:
      * Returns false if no set cover exists within current lambda
      *
      * Important: we can use all facilities except the extra one
+     *
+     * The coverage heap and covered customers are not rebuilt: ranks are updated only for facilities whose
+     * matched customers changed since the last call (logged by the residual graph) and facilities touched
+     * by the previous set cover, so the cost depends on changes of the matching and on the work of the greedy itself
      */
     bool findSetCover() {
-        logger->start("set cover check time");
-        std::fill(customer_antirank.begin(), customer_antirank.end(), 0);
-        //initialize single linked lists and heaps
+        this->logger->start("set cover check time");
         this->result.clear();
-        fHeap<FacilityRank,long> heap;
-        std::vector<std::forward_list<long>> matching;
-        heap.sign = 1; //make heap decreasing order
-        this->fillQueueOfMatchedNodesPerFacility(matching, heap);
+        iteration_arena.reset();
+        CoverageHeap& heap = coverage_heap;
+        this->updateCoverageHeap(heap);
         if (heap.size() == 0) {
             return false; //out of available facilities for some reason (probably border case)
         }
 
-        std::vector<long> covered(this->source_count, 0);
+        this->resetCoveredCustomers();
 	    this->max_coverage = heap.getTopValue().coverage;
-        bool if_result = greedySetCover(matching, covered, heap);
-        this->updateCustomerAntirank(covered);
-        logger->add2("total covered final", total_covered);
+        bool if_result = parallel_cover_epsilon > 0 ? parallelGreedySetCover(matching, covered.data(), heap)
+                                                    : greedySetCover(matching, covered.data(), heap);
+        this->restoreCoverageHeap(heap);
+        this->logger->add2("total covered final", total_covered);
 
-        logger->finish("set cover check time");
+        this->logger->finish("set cover check time");
         return if_result;
     }
 
-    void updateCustomerAntirank(std::vector<long>& covered) {
-        for (long i = 0; i < source_count; i++) {
-            this->customer_antirank[i] += (covered[i] == 0);
+    /*
+     * Customers not covered in the last set cover have antirank 1, the others 0
+     */
+    void resetCoveredCustomers() {
+        for (auto customer : covered_customers) {
+            covered[customer] = 0;
+            covered_bits[coverage_word(customer)] = 0;
+            this->customer_antirank[customer] = 1;
         }
+        covered_customers.clear();
+    }
+
+    inline FacilityRank getFacilityRank(long bi_node_id) {
+        return FacilityRank(this->edges.outdegree(bi_node_id), this->last_used[this->get_target_id_by_bi_node_id(bi_node_id)], bi_node_id);
     }
 
     /*
      * Rank facilities according to matched nodes and the last iteration when it was used
+     * The first call ranks all facilities, later calls only those with changed arcs in the residual graph
      */
-     void fillQueueOfMatchedNodesPerFacility(std::vector<std::forward_list<long>>& matching, fHeap<FacilityRank,long>& heap) {
-        matching.resize(this->get_facility_count()-1);//without extra node
-        for (long i = source_count; i < graph_size-1; i++) {
-            forward_list<long> linked_nodes;
-            long target_id = this->get_target_id_by_bi_node_id(i);
-            //there can be many matched vertices because of capacities
-            long matching_count = 0;
-            EdgeIterator it;
-            for (it = edges[i].begin(); it != edges[i].end(); it++) {
-                linked_nodes.push_front(it->first);
-                matching_count++;
-            }
-            //put in a heap
-            if (matching_count >= 0) {
-                heap.enqueue(i, FacilityRank(matching_count,this->last_used[target_id]));
-            }
-            matching[target_id] = linked_nodes;
+    void updateCoverageHeap(CoverageHeap& heap) {
+        if (!coverage_ready) {
+            heap.clear();
+            matching.assign(this->get_facility_count()-1, MatchedCustomers{nullptr, nullptr, 0, 0, -1});//without extra node
+            for (long i = this->source_count; i < this->graph_size-1; i++) {
+                heap.enqueue(i, this->getFacilityRank(i));
+            }
+            covered.assign(this->source_count, 0);
+            covered_bits.assign(coverage_word(this->source_count) + 1, 0);
+            covered_customers.clear();
+            std::fill(this->customer_antirank.begin(), this->customer_antirank.end(), 1);
+            this->edges.trackChanges(true);
+            coverage_ready = true;
+            return;
         }
-    };
+        this->edges.takeChangedNodes(changed_nodes);
+        for (auto node : changed_nodes) {
+            if (node >= this->source_count && node < this->graph_size-1) {
+                heap.updateorenqueue(node, this->getFacilityRank(node));
+            }
+        }
+    }
 
+    /*
+     * Put facilities dequeued by the set cover back with their full rank, their lists of customers are dropped with the arena
+     */
+    void restoreCoverageHeap(CoverageHeap& heap) {
+        for (auto bi_node_id : touched_facilities) {
+            heap.updateorenqueue(bi_node_id, this->getFacilityRank(bi_node_id));
+            matching[this->get_target_id_by_bi_node_id(bi_node_id)].size = -1;
+        }
+        touched_facilities.clear();
+    }
+
+    /*
+     * Copy customers matched with a facility into the arena to compact them during the set cover.
+     * If there are at least bitset_min_density customers per word of their range, they are stored as a bitmap
+     */
+    void loadMatchedCustomers(long bi_node_id, MatchedCustomers& customers) {
+        touched_facilities.push_back(bi_node_id);
+        long matching_count = this->edges.outdegree(bi_node_id);
+        customers.size = matching_count;
+        customers.customers = nullptr;
+        customers.bits = nullptr;
+        if (matching_count == 0) {
+            return;
+        }
+        long first_customer = this->edges[bi_node_id][0].first;
+        long last_customer = first_customer;
+        for (auto& arc : this->edges[bi_node_id]) {
+            first_customer = std::min(first_customer, (long) arc.first);
+            last_customer = std::max(last_customer, (long) arc.first);
+        }
+        customers.first_word = coverage_word(first_customer);
+        customers.words = coverage_word(last_customer) - customers.first_word + 1;
+        if (bitset_min_density > 0 && matching_count >= bitset_min_density * customers.words) {
+            customers.bits = iteration_arena.allocate<uint64_t>(customers.words, 0);
+            for (auto& arc : this->edges[bi_node_id]) {
+                customers.bits[coverage_word(arc.first) - customers.first_word] |= coverage_bit(arc.first);
+            }
+            return;
+        }
+        customers.customers = iteration_arena.allocate<long>(matching_count);
+        for (long j = 0; j < matching_count; j++) {
+            customers.customers[j] = this->edges[bi_node_id][j].first;
+        }
+    }
+
+    template<typename V>
+    inline void forEachCustomer(MatchedCustomers& customers, V visit) {
+        if (customers.bits != nullptr) {
+            for_each_bit(customers.bits, customers.first_word, customers.words, visit);
+        } else {
+            for (long i = 0; i < customers.size; i++) {
+                visit(customers.customers[i]);
+            }
+        }
+    }
 
-    bool greedySetCover(std::vector<std::forward_list<long>>& matching, std::vector<long>& local_covered, fHeap<FacilityRank,long>& heap) {
+    inline void coverCustomer(long customer, long* local_covered) {
+        local_covered[customer]++;
+        covered_bits[coverage_word(customer)] |= coverage_bit(customer);
+        this->customer_antirank[customer] = 0;
+        covered_customers.push_back(customer);
+        total_covered++;
+    }
+
+    bool greedySetCover(std::vector<MatchedCustomers>& matching, long* local_covered, CoverageHeap& heap) {
         long heap_iterations = 0;
-        total_covered = 0;
+        total_covered = this->removed_customers;
         while (pickAnotherFacility(matching, local_covered, heap)) {
             heap_iterations++;
         }
 //        std::cout << total_covered << std::endl;
 //        logger->add2("greedy deheap iterations", heap_iterations);
-        return (total_covered == source_count);
+        return (total_covered == this->source_count);
     }
 
-    bool pickAnotherFacility(std::vector<std::forward_list<long>>& matching, std::vector<long>& local_covered, fHeap<FacilityRank,long>& heap) {
+    bool pickAnotherFacility(std::vector<MatchedCustomers>& matching, long* local_covered, CoverageHeap& heap) {
         if (heap.size() == 0) {
             return false;
         }
@@ -270,9 +433,12 @@ public:
         heap.dequeue(bi_node_id, rank);
         long init_target_coverage = rank.coverage;
         long target_id = this->get_target_id_by_bi_node_id(bi_node_id);
+        if (matching[target_id].size < 0) {
+            this->loadMatchedCustomers(bi_node_id, matching[target_id]);
+        }
 
         //test if matching is not empty. If so - return false immediately
-        if (matching[target_id].begin() == matching[target_id].end()) {
+        if (matching[target_id].size == 0) {
             return false;
         }
         // check which matched vertex is still not covered and delete covered ones
@@ -288,7 +454,7 @@ public:
             // otherwise add to the result and update coverage
             result.push_back(target_id);
 
-            double relative_gain = (double) new_covered_by_target_count / (double) (source_count - total_covered);
+            double relative_gain = (double) new_covered_by_target_count / (double) (this->source_count - total_covered);
 //            logger->add2("relative gain", relative_gain);
 //            logger->add2("matching count", new_covered_by_target_count);
 //            logger->add2("left count", source_count - total_covered);
@@ -299,41 +465,129 @@ public:
             //update usage history here
             this->last_used[target_id] = this->capacity_iteration;
 
-            for (auto it = matching[target_id].begin(); it != matching[target_id].end(); it++) {
-                //every node in single-linked list must not be covered yet
-                local_covered[(*it)]++;
-                total_covered++;
-            }
+            //every node in the list must not be covered yet
+            this->forEachCustomer(matching[target_id], [&](long customer) {
+                this->coverCustomer(customer, local_covered);
+            });
             return true;
         }
     }
 
-    long remove_covered_customers_from_queue(std::forward_list<long>& queue, std::vector<long>& coverage) {
-        // linked list can delete only the NEXT element, so we are checking each next element,
-        // and then the first one separately
-        long non_covered_count = 0;
-        auto it = queue.begin();
-        auto prev_it = queue.begin();
-        it++;
-        while (it != queue.end()) {
-            long pair_id = (*it);
-            if (coverage[pair_id]) {
-                //delete from a linked-list
-                queue.erase_after(prev_it);
-                it = prev_it;
-            } else {
-                non_covered_count++;
-                prev_it = it;
+    /*
+     * Parallel greedy set cover with gain buckets, in the style of Blelloch, Peng and Tangwongsan.
+     *
+     * A round takes from the coverage heap all facilities whose marginal coverage can be at least t = top/(1+epsilon)
+     * and recalculates their coverage in parallel. Every uncovered customer of a facility with coverage >= t is claimed
+     * by the best such facility (the first dequeued one) with an atomic minimum, and a facility is chosen if it won
+     * at least t/(1+epsilon) customers. Chosen facilities are disjoint in won customers, so each of them adds at least
+     * 1/(1+epsilon)^2 of the largest marginal coverage, as the sequential greedy up to that factor. The best facility
+     * wins all its customers, so a round always chooses one. Claims are deterministic, so is the result.
+     *
+     * Returns true if all customers are covered
+     */
+    bool parallelGreedySetCover(std::vector<MatchedCustomers>& matching, long* local_covered, CoverageHeap& heap) {
+        const long NO_CLAIM = std::numeric_limits<long>::max();
+        total_covered = this->removed_customers;
+        if (customer_claims.size() != this->source_count) {
+            std::vector<std::atomic<long>> claims(this->source_count);
+            customer_claims.swap(claims);
+            for (auto& claim : customer_claims) {
+                claim.store(NO_CLAIM, std::memory_order_relaxed);
             }
-            it++;
         }
-        //process the first one
-        long first_node = (*queue.begin());
-        if (coverage[first_node]) {
-            queue.pop_front();
-        } else {
-            non_covered_count++;
+        double factor = 1 + parallel_cover_epsilon;
+        std::vector<long> candidates;
+        std::vector<FacilityRank> ranks;
+        std::vector<long> won;
+        while (total_covered < this->source_count && heap.size() > 0 && heap.getTopValue().coverage > 0) {
+            double threshold = heap.getTopValue().coverage / factor;
+            candidates.clear();
+            ranks.clear();
+            while (heap.size() > 0 && heap.getTopValue().coverage >= threshold) {
+                long bi_node_id;
+                FacilityRank rank;
+                heap.dequeue(bi_node_id, rank);
+                MatchedCustomers& customers = matching[this->get_target_id_by_bi_node_id(bi_node_id)];
+                if (customers.size < 0) {
+                    this->loadMatchedCustomers(bi_node_id, customers); //the arena is not thread-safe
+                }
+                candidates.push_back(bi_node_id);
+                ranks.push_back(rank);
+            }
+            long candidate_count = candidates.size();
+            won.assign(candidate_count, 0);
+
+            //lists of facilities are compacted independently, covered customers are only read
+            #pragma omp parallel for schedule(dynamic, 16)
+            for (long i = 0; i < candidate_count; i++) {
+                MatchedCustomers& customers = matching[this->get_target_id_by_bi_node_id(candidates[i])];
+                ranks[i].coverage = this->remove_covered_customers_from_queue(customers, local_covered);
+            }
+            #pragma omp parallel for schedule(dynamic, 16)
+            for (long i = 0; i < candidate_count; i++) {
+                if (ranks[i].coverage < threshold) {
+                    continue;
+                }
+                this->forEachCustomer(matching[this->get_target_id_by_bi_node_id(candidates[i])], [&](long customer) {
+                    long claim = customer_claims[customer].load(std::memory_order_relaxed);
+                    while (i < claim && !customer_claims[customer].compare_exchange_weak(claim, i, std::memory_order_relaxed)) {}
+                });
+            }
+            #pragma omp parallel for schedule(dynamic, 16)
+            for (long i = 0; i < candidate_count; i++) {
+                if (ranks[i].coverage < threshold) {
+                    continue;
+                }
+                this->forEachCustomer(matching[this->get_target_id_by_bi_node_id(candidates[i])], [&](long customer) {
+                    won[i] += customer_claims[customer].load(std::memory_order_relaxed) == i;
+                });
+            }
+            #pragma omp parallel for schedule(dynamic, 16)
+            for (long i = 0; i < candidate_count; i++) {
+                if (ranks[i].coverage < threshold) {
+                    continue;
+                }
+                this->forEachCustomer(matching[this->get_target_id_by_bi_node_id(candidates[i])], [&](long customer) {
+                    customer_claims[customer].store(NO_CLAIM, std::memory_order_relaxed);
+                });
+            }
+
+            //choose in the order of the heap, the rest go back with their recalculated coverage
+            for (long i = 0; i < candidate_count; i++) {
+                long target_id = this->get_target_id_by_bi_node_id(candidates[i]);
+                if (ranks[i].coverage < threshold || won[i] < threshold / factor) {
+                    heap.enqueue(candidates[i], ranks[i]);
+                    continue;
+                }
+                result.push_back(target_id);
+                if (result.size() > this->required_facilities + lambda) {
+                    return false;
+                }
+                this->last_used[target_id] = this->capacity_iteration;
+                this->forEachCustomer(matching[target_id], [&](long customer) {
+                    if (local_covered[customer] == 0) {
+                        this->coverCustomer(customer, local_covered);
+                    }
+                });
+            }
+        }
+        return (total_covered == this->source_count);
+    }
+
+    long remove_covered_customers_from_queue(MatchedCustomers& queue, long* coverage) {
+        if (queue.bits != nullptr) {
+            queue.size = subtract_covered_bits(queue.bits, covered_bits.data() + queue.first_word, queue.words);
+            return queue.size;
+        }
+        // compact not covered customers to the beginning of the array
+        long non_covered_count = 0;
+        for (long i = 0; i < queue.size; i++) {
+            long pair_id = queue.customers[i];
+            if (!coverage[pair_id]) {
+                queue.customers[non_covered_count++] = pair_id;
+            }
         }
+        queue.size = non_covered_count;
         return non_covered_count;
     }
 
@@ -346,31 +600,33 @@ public:
     //so they do not interfere
     bool increaseCapacities(std::vector<int>& complete_sources) {
 
-        std::vector<long> speed(source_count);
+        long* speed = iteration_arena.allocate<long>(this->source_count);
         long max = 0;
         long total_covered = 0;
         long total_complete = 0;
-        for (long i = 0; i < source_count; i++) {
+        for (long i = 0; i < this->source_count; i++) {
             speed[i] = this->customer_antirank[i];
             total_covered += (speed[i] == 0);//total covered
             total_complete += (complete_sources[i]);
             speed[i] *= (1 - complete_sources[i]); //do not increase those with all component explored even if uncovered (hopping for another set cover attempt)
             max = std::max(speed[i], max);
         }
-        if (total_complete == source_count) {
+        if (total_complete == this->source_count) {
             throw infeasible_solution;
         }
         if (max == 0) {
-            for (long i = 0; i < speed.size(); i++) {
+            for (long i = 0; i < this->source_count; i++) {
                 speed[i] = (1-complete_sources[i]);
             }
+        } else if (this->alpha > 0) {
+            this->updatePace(total_covered);
+            long max_increment = 0;
+            for (long i = 0; i < this->source_count; i++) {
+                speed[i] *= this->getDemandIncrement(i, total_covered);
+                max_increment = std::max(max_increment, speed[i]);
+            }
+            this->logger->add2("demand increment", max_increment);
         }
-//        else {
-//            double coef = 1 + this->alpha * (double) total_covered / (double)source_count;
-//            for (long i = 0; i < speed.size(); i++) {
-//                speed[i] = (long)(coef * (double)speed[i]/(double)max);
-//            }
-//        }
 
         if (this->greedyMatching) {
             this->resetAssignmentForGreedyMatching();
@@ -378,14 +634,42 @@ public:
 
         bool anychanges = false;
         long total_increased = 0;
-        for (long vid = 0; vid < source_count; vid++) {
-            for (long j = 0; j < speed[vid]; j++) {
-                total_increased++;
-                int success = this->increaseCapacity(vid);
-                if (!success) {
-                    complete_sources[vid] = 1; //fully explored component
-                } else {
-                    anychanges = true;
+        long searches_before = this->shortest_path_searches;
+        if (this->batchedMatching && !this->greedyMatching) {
+            //increase all demands first and match them together
+            for (long vid = 0; vid < this->source_count; vid++) {
+                for (long j = 0; j < speed[vid]; j++) {
+                    total_increased++;
+                    if (!this->increaseDemand(vid)) {
+                        complete_sources[vid] = 1;
+                        break;
+                    }
+                }
+            }
+            long matched_before = 0;
+            for (long vid = 0; vid < this->source_count; vid++) {
+                matched_before += this->total_matched[vid];
+            }
+            std::vector<I> unmatched_sources = this->matchBatched();
+            for (auto it = unmatched_sources.begin(); it != unmatched_sources.end(); it++) {
+                complete_sources[(*it)] = 1; //fully explored component
+            }
+            long matched_after = 0;
+            for (long vid = 0; vid < this->source_count; vid++) {
+                matched_after += this->total_matched[vid];
+            }
+            anychanges = (matched_after > matched_before);
+        } else {
+            for (long vid = 0; vid < this->source_count; vid++) {
+                for (long j = 0; j < speed[vid]; j++) {
+                    total_increased++;
+                    int success = this->increaseCapacity(vid);
+                    if (!success) {
+                        complete_sources[vid] = 1; //fully explored component
+                        break;
+                    } else {
+                        anychanges = true;
+                    }
                 }
             }
         }
@@ -397,16 +681,40 @@ public:
                 complete_sources[(*it)] = 1;
             }
         }
+        this->logger->add2("shortest path searches", this->shortest_path_searches - searches_before);
 
         return anychanges;
     }
 
+    /*
+     * Demand of an uncovered customer grows by the share alpha * pace * (uncovered customers) of its current demand,
+     * at least by one: geometrically while the cover is far from feasible, by one near the end
+     */
+    long getDemandIncrement(long source_id, long total_covered) {
+        double uncovered_share = (double) (this->source_count - total_covered) / (double) this->source_count;
+        //greedy matching is rebuilt every iteration from the full demands, SIA keeps the matched ones
+        long demand = this->greedyMatching ? -this->full_node_excess[source_id] : this->total_matched[source_id];
+        return std::max(1L, (long) (this->alpha * this->pace * uncovered_share * (double) demand));
+    }
+
+    void updatePace(long total_covered) {
+        if (this->pace_backoff && this->previous_covered >= 0) {
+            if (total_covered <= this->previous_covered) {
+                this->pace *= 2;
+            } else {
+                this->pace = std::max(1.0, this->pace / 2);
+            }
+        }
+        this->previous_covered = total_covered;
+        this->logger->add2("pace", this->pace);
+    }
+
     void resetAssignmentForGreedyMatching() {
         for (auto i = 0; i < this->edge_generator->n; i++) {
             this->node_excess[i] = this->full_node_excess[i];
         }
         for (auto i = this->edge_generator->n; i < this->edges.size(); i++) {
-            this->edges[i] = Adjlist();
+            this->edges.clear(i);
             this->node_excess[i] = this->full_node_excess[i];
         }
     }
@@ -415,25 +723,22 @@ public:
      * Select worst customers: find worst matching and select closest not-matched facility
      *
      * - Traverse customers and select better options for each one.
-     *    - if a customer does not have any better options - skip him, he already is covered by best option
-     * - Select top-k using heapsort to satisfy facility requirement
-     *    - if heapsort is larger than k, then we can shrink size of heap, as we never use more than k
-     *      because each element in heap is a new facility after deheaping
+     *    - the option of a customer is its nearest facility, kept by the edge generator (see EdgeGenerator::getNearestEdge)
+     *    - the gain of the option is the distance to the best chosen facility matched with the customer minus the distance
+     *      to the option, customers not matched with any chosen facility have an infinite gain
+     *    - if the option of a customer is already chosen - skip him, he already is covered by best option
+     *    - if two customers request for the same facility, the facility keeps the largest gain
+     * - Select top-k by gain: heapify all requested facilities in O(n) and pop at most k in O(k log n)
      *    - if all selected better options is less than required left facilities, then select any available facilities
      *      because everyone already have the best option so far
-     *    - if two customers request for the same facility, then we need to select more facilities, but it is
-     *      not likely, so we just ignore again if some particular facility is already chosen
-     *      hoping that it will not be capacitated. if it will, then it goes for a random facility chosen later
-     *      for this purpose we maintain a full heap, without reducing size, as we can pull more than k
-     *
      */
     void locateRest() {
         long facilities_left = required_facilities - this->result.size();
-        logger->add("facilities left after termination", facilities_left);
+        this->logger->add("facilities left after termination", facilities_left);
         if (facilities_left <= 0) {
             return; //no problem
         }
-        logger->start("locate rest time");
+        this->logger->start("locate rest time");
 
         //mark which facility is chosen, created here because result is built several times
         std::vector<bool> result_flag(this->edge_generator->m, false);
@@ -441,40 +746,50 @@ public:
             result_flag[this->result[i]] = true;
         }
 
-        std::vector<long> source_best(source_count, LONG_MAX);
+        std::vector<long> source_best(this->source_count, LONG_MAX);
         for (long i = 0; i < this->result.size(); i++) {
             //each element in result array is a facility location
             //bipartite graph still holds customers that were matched to that location
             //note that one customer can be matched with several facilities
-            //so for current facility location we get all covered customers, add (or update!) them in the heap
-            long location_vid = this->result[i] + source_count; //result contains ids in a network graph
+            long location_vid = this->result[i] + this->source_count; //result contains ids in a network graph
             //traverse each matched customer in the bipartite graph
-            for (EdgeIterator it = edges[location_vid].begin(); it != edges[location_vid].end(); it++) {
+            for (EdgeIterator it = this->edges[location_vid].begin(); it != this->edges[location_vid].end(); it++) {
                 long cur_dist = -it->second; //minus because the edge is inverted
                 source_best[it->first] = std::min(source_best[it->first], cur_dist);
             }
         }
-        //now source_best should contain each customer some non-infinite number
-        //mark -1 in source_best nodes which we explored the target
-        fHeap<long,long> partialHeapsort;
-        for (long i = 0; i < this->edge_generator->edgeMemory.size(); i++) { //refactor this by saving in mather history per each node
-            newEdge e = this->edge_generator->edgeMemory[i];
-            if (source_best[e.source_node] >= 0) {
-                partialHeapsort.enqueue(e.target_node-this->edge_generator->n, source_best[i] - e.weight);
-                source_best[e.source_node] = -1;
+
+        //the largest gain per requested facility, facilities are listed once in the order of the first request
+        std::vector<long> facility_gain(this->edge_generator->m, -1);
+        std::vector<std::pair<long,long>> requests; //(gain, -facility), so that smaller ids win ties
+        for (long i = 0; i < this->source_count; i++) {
+            newEdge e = this->edge_generator->getNearestEdge(i);
+            if (!e.exists || this->isRemovedCustomer(i)) {
+                continue;
+            }
+            long location = e.target_node - this->edge_generator->n;
+            if (result_flag[location]) {
+                continue;
             }
+            long gain = source_best[i] == LONG_MAX ? LONG_MAX : source_best[i] - e.weight;
+            if (facility_gain[location] < 0) {
+                requests.push_back(std::make_pair(0L, -location));
+            }
+            facility_gain[location] = std::max(facility_gain[location], gain);
+        }
+        for (auto& request : requests) {
+            request.first = facility_gain[-request.second];
         }
 
-        //here we deheap ID of customer in source index; then, we should place there facility
         //result should contain id of facility in target_index array
-        long new_location;
-        while ((facilities_left > 0) && (partialHeapsort.size() > 0)) {
-            partialHeapsort.dequeue(new_location);
-            if (!result_flag[new_location]) {
-                this->result.push_back(new_location); //put location in a network
-                result_flag[new_location] = true;
-                facilities_left--;
-            }
+        std::make_heap(requests.begin(), requests.end());
+        while ((facilities_left > 0) && (requests.size() > 0)) {
+            std::pop_heap(requests.begin(), requests.end());
+            long new_location = -requests.back().second;
+            requests.pop_back();
+            this->result.push_back(new_location); //put location in a network
+            result_flag[new_location] = true;
+            facilities_left--;
         }
 
         if (facilities_left > 0) {
@@ -489,23 +804,102 @@ public:
             }
         }
 
-        logger->finish("locate rest time");
+        this->logger->finish("locate rest time");
+    }
+
+    bool isBudgetExhausted() {
+        if ((this->iteration_budget > 0) && (capacity_iteration - this->wma_first_iteration >= this->iteration_budget)) {
+            return true;
+        }
+        return (this->time_budget > 0) && (getWMASeconds() >= this->time_budget);
+    }
+
+    /*
+     * Iterations between evaluations of the partial cover. A budget alone also gives the objectives on the way,
+     * about ten points over an iteration budget or every ten iterations for a time budget. Negative - never
+     */
+    long getAnytimePeriod() {
+        if (this->anytime_period != 0) {
+            return std::max(0L, this->anytime_period);
+        }
+        if (this->iteration_budget > 0) {
+            return std::max(1L, this->iteration_budget / 10);
+        }
+        return (this->time_budget > 0) ? 10 : 0;
+    }
+
+    double getWMASeconds() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - this->wma_start).count();
+    }
+
+    /*
+     * Complete the current cover to the required number of facilities as the final result would be and evaluate it.
+     * Logs the objective with the wall time and the iteration, and keeps the best cover.
+     * Locating and matching inside log to a scratch logger, so that keys of the final result have one value
+     */
+    long evaluatePartialCover() {
+        std::vector<long> cover = this->result;
+        Logger* logger = this->logger;
+        Logger scratch;
+        this->logger = &scratch;
+        if (this->result.size() > this->required_facilities) {
+            this->result.resize(this->required_facilities);
+        }
+        this->locateRest();
+        std::vector<long> final_excess;
+        long cost = this->evaluateResult(final_excess);
+        this->logger = logger;
+
+        this->logger->add("anytime objective", cost);
+        this->logger->add("anytime seconds", getWMASeconds());
+        this->logger->add("anytime iteration", capacity_iteration);
+        if (this->best_result.empty() || cost <= this->best_cost) {
+            this->best_result = this->result;
+            this->best_cost = cost;
+            this->best_excess.swap(final_excess);
+        }
+        this->result.swap(cover);
+        return cost;
     }
 
     void locateFacilities() {
-        logger->start("runtime");
-        logger->start("matching");
+        this->logger->start("runtime");
+        this->logger->start("matching");
         this->match(); //calculate preliminary matching
-        logger->finish("matching");
+        this->logger->finish("matching");
 
-        // increase customer capacities until we can choose a covering subset of matched services
         this->capacity_iteration = 0; //used for ranking @todo move to parameters
-        std::vector<int> complete_sources(source_count, 0);
+        this->complete_sources.assign(this->source_count, 0);
+        this->locateByWMA();
+
+        this->logger->finish("runtime");
+    }
+
+    /*
+     * Increase customer capacities from the current matching until we can choose a covering subset of matched services
+     */
+    void locateByWMA() {
+        this->wma_start = std::chrono::steady_clock::now();
+        this->wma_first_iteration = capacity_iteration;
+        this->best_result.clear();
+        this->result_evaluated = false;
+        long period = this->getAnytimePeriod();
         while (!this->findSetCover()) {
             capacity_iteration++;
-            logger->start("matching");
+            if ((period > 0) && (capacity_iteration % period == 0)) {
+                this->evaluatePartialCover();
+            }
+            if (this->isBudgetExhausted()) {
+                //the partial cover holds the best covering facilities first, the rest is located as usual
+                this->logger->add("budget exhausted", capacity_iteration);
+                if (this->result.size() > this->required_facilities) {
+                    this->result.resize(this->required_facilities);
+                }
+                break;
+            }
+            this->logger->start("matching");
 //            std::cout << this->total_covered << std::endl;
-            if (!increaseCapacities(complete_sources)) {
+            if (!increaseCapacities(this->complete_sources)) {
                 //try more - check if set cover result is the same. no more facilities only if absolutely all customers are full
                 std::cout << "nothing added with coverage " << this->total_covered << std::endl;
 
@@ -514,13 +908,119 @@ public:
                 break;
                 //throw no_more_capacities_to_increase;
             }
-            logger->finish("matching");
+            this->logger->finish("matching");
         }
-        logger->add("number of iterations", capacity_iteration);
+        this->logger->add("number of iterations", capacity_iteration);
         locateRest(); //locate rest of facilities (if a set that covers customers is smaller than required number of facilities)
+        if (period > 0) {
+            //the final cover is one more point of the anytime curve, an earlier one may be better
+            this->evaluatePartialCover();
+            this->result = this->best_result;
+            this->result_evaluated = true;
+        }
         this->state = LOCATED;
+    }
+
+    /*
+     * Dynamic updates after the facilities are located (see run): customers are removed, added or relocated and
+     * facilities get other capacities. The matching is repaired by SIA right away (see Matcher::removeSource),
+     * update() continues WMA from the repaired matching and the persistent set cover.
+     *
+     * Customers keep their ids, as facilities follow them in the bipartite graph: a removed customer leaves
+     * an empty slot with zero demand that addCustomer takes again. Greedy matching is rebuilt every
+     * iteration anyway and is not supported.
+     */
+    void checkDynamicUpdate() {
+        if (this->state != LOCATED) {
+            throw std::logic_error("Facilities should be located before dynamic updates");
+        }
+        if (this->greedyMatching) {
+            throw std::logic_error("Dynamic updates repair SIA matching only");
+        }
+        this->result_evaluated = false;
+    }
+
+    inline bool isRemovedCustomer(long customer) {
+        return this->full_node_excess[customer] == 0;
+    }
+
+    void removeCustomer(long customer) {
+        this->checkDynamicUpdate();
+        if (this->isRemovedCustomer(customer)) {
+            return;
+        }
+        this->removeSource(customer);
+        this->full_node_excess[customer] = 0;
+        this->complete_sources[customer] = 1;
+        this->customer_antirank[customer] = 0;
+        this->removed_customers++;
+        this->free_customers.push_back(customer);
+    }
+
+    /*
+     * Move a customer to another node of the network, the demand starts from one again
+     * The network is shared with other choosers, so nodes of customers are kept in source_indexes of the chooser
+     */
+    void relocateCustomer(long customer, long node_id) {
+        this->checkDynamicUpdate();
+        if (this->isRemovedCustomer(customer)) {
+            this->removed_customers--;
+        }
+        this->relocateSource(customer, node_id);
+        this->full_node_excess[customer] = -1;
+        this->complete_sources[customer] = 0;
+        this->customer_antirank[customer] = 1;
+        if (this->source_reverse_index[this->source_indexes[customer]] == customer) {
+            this->source_reverse_index.erase(this->source_indexes[customer]);
+        }
+        this->source_indexes[customer] = node_id;
+        this->source_reverse_index[node_id] = customer;
+    }
+
+    /*
+     * Put a new customer at a node into the slot of a removed one, returns its id
+     */
+    long addCustomer(long node_id) {
+        while (!this->free_customers.empty()) {
+            long customer = this->free_customers.back();
+            this->free_customers.pop_back();
+            if (this->isRemovedCustomer(customer)) { //otherwise the slot was taken by relocateCustomer
+                this->relocateCustomer(customer, node_id);
+                return customer;
+            }
+        }
+        throw std::logic_error("No slot of a removed customer to add a customer");
+    }
+
+    /*
+     * Capacities become per facility at the first change
+     */
+    void setFacilityCapacity(long facility_id, long capacity) {
+        this->checkDynamicUpdate();
+        if (this->partially_uniform) {
+            throw std::logic_error("Capacities of partially uniform facilities cannot change");
+        }
+        if (this->uniform_capacities) {
+            this->target_capacities.assign(this->edge_generator->m, this->facility_capacity);
+            this->uniform_capacities = false;
+        }
+        long delta = capacity - this->target_capacities[facility_id];
+        long bi_node_id = this->get_bi_node_id_by_target_id(facility_id);
+        this->changeTargetCapacity(bi_node_id, delta);
+        this->target_capacities[facility_id] = capacity;
+        this->full_node_excess[bi_node_id] += delta;
+    }
 
-        logger->finish("runtime");
+    /*
+     * Locate facilities for the updated customers and capacities, returns the objective
+     */
+    long update() {
+        this->checkDynamicUpdate();
+        this->logger->start("update time");
+        this->locateByWMA();
+        this->calculateResult();
+        this->logger->finish("update time");
+        return this->totalCost;
     }
 
     inline long get_node_id_by_facility_id(long facility_id) {
@@ -532,7 +1032,7 @@ public:
     }
 
     inline long get_facility_id_by_node_id(long node_id) {
-        return (this->all_nodes_available) ? node_id : dynamic_cast<TargetExploringEdgeGenerator<long,long>*>(this->edge_generator)->get_facility_id_by_node_id(node_id);
+        return (this->all_nodes_available) ? node_id : this->target_reverse_index[node_id];
     }
 
     inline long get_source_id_by_node_id(long node_id) {
@@ -552,7 +1052,7 @@ public:
     }
 
     inline long get_facility_count() {
-        return graph_size - source_count; //todo what about excess node?
+        return this->graph_size - this->source_count; //todo what about excess node?
     }
 
     std::vector<long> get_chosen_facility_node_ids() {
@@ -563,13 +1063,10 @@ public:
         return node_ids;
     }
 
-    long calculateResult() {
-        //calculate Total Sum
-        if (this->state != LOCATED) {
-            throw std::logic_error("Facilities should be located before computing result");
-        }
-        logger->start("result final calculation time");
-
+    /*
+     * Cost of the assignment of customers to facilities of the result, <final_excess> gets free capacities
+     */
+    long evaluateResult(std::vector<long>& final_excess) {
         //run matching in resulting biparite graph, but having capacity of 1 only and having customers
         //on the right side of bipartite graph
 
@@ -577,37 +1074,91 @@ public:
         //create an edge generator with calculated distances between known facilities and customers
         //run new matcher
 
-        std::string facility_index_list = "";
         std::vector<long> new_excess(this->source_indexes.size() + this->result.size());
         for (long i = source_indexes.size(); i < new_excess.size(); i++) {
             long facility_id = this->result[i-source_indexes.size()];
             new_excess[i] = this->get_capacity_by_facility_id(facility_id);
-            facility_index_list += std::to_string(this->get_node_id_by_facility_id(facility_id)) + ",";
         }
-        logger->add("facilities_indexes", facility_index_list);
+        this->logFacilityIndexes();
 
         for (long i = 0; i < this->source_indexes.size(); i++) {
-            new_excess[i] = -1;
+            new_excess[i] = this->isRemovedCustomer(i) ? 0 : -1;
         }
         std::vector<long> chosen_node_ids = this->get_chosen_facility_node_ids();
-        TargetExploringEdgeGenerator<long, long> bigraph_generator(*this->network, chosen_node_ids);
-        Matcher<long,long,long> M(&bigraph_generator, new_excess, this->logger, false);
-        M.greedyMatching = this->greedyMatching * this->objective_matching; //objective matching 0 means there should be SIA for objective calculation
-        M.greedyMatchingOrder = this->greedyMatchingOrder;
-        M.network = this->network;
-        M.match();
-        M.calculateResult(); // we CARE here if some customers are assigned to the extra node
-        this->totalCost = M.result_weight;
+        TargetExploringEdgeGenerator<I,W> bigraph_generator(*this->network, this->source_indexes, chosen_node_ids);
+        long cost;
+        if (this->auction_objective && !(this->greedyMatching && this->objective_matching)) {
+            AuctionMatcher<long,W,I> A(&bigraph_generator, new_excess, this->logger, false);
+            A.match();
+            A.calculateResult();
+            cost = A.result_weight;
+            final_excess.swap(A.node_excess);
+        } else if (this->objective_parts > 0 && !this->network->coords.empty() && !(this->greedyMatching && this->objective_matching)) {
+            std::vector<Coords> coords;
+            for (auto node_id : this->source_indexes) {
+                coords.push_back(this->network->coords[node_id]);
+            }
+            for (auto node_id : chosen_node_ids) {
+                coords.push_back(this->network->coords[node_id]);
+            }
+            std::vector<long> part_of = PartitionedMatcher<long,W,I>::hilbertPartition(coords, new_excess, this->objective_parts);
+            PartitionedMatcher<long,W,I> P(&bigraph_generator, new_excess, part_of, this->objective_parts, this->logger, false);
+            P.batchedMatching = this->batchedMatching;
+            P.match();
+            P.calculateResult();
+            cost = P.result_weight;
+            final_excess.swap(P.node_excess);
+        } else {
+            Matcher<long,W,I> M(&bigraph_generator, new_excess, this->logger, false);
+            M.greedyMatching = this->greedyMatching * this->objective_matching; //objective matching 0 means there should be SIA for objective calculation
+            M.greedyMatchingOrder = this->greedyMatchingOrder;
+            M.greedyChunk = this->greedyChunk;
+            M.greedyDeterministic = this->greedyDeterministic;
+            M.batchedMatching = this->batchedMatching;
+            M.epsilon = this->epsilon;
+            M.network = this->network;
+            M.match();
+            M.calculateResult(); // we CARE here if some customers are assigned to the extra node
+            cost = M.result_weight;
+            final_excess.swap(M.node_excess);
+        }
+        return cost;
+    }
+
+    void logFacilityIndexes() {
+        std::string facility_index_list = "";
+        for (auto facility_id : this->result) {
+            facility_index_list += std::to_string(this->get_node_id_by_facility_id(facility_id)) + ",";
+        }
+        this->logger->add("facilities_indexes", facility_index_list);
+    }
+
+    long calculateResult() {
+        //calculate Total Sum
+        if (this->state != LOCATED) {
+            throw std::logic_error("Facilities should be located before computing result");
+        }
+        this->logger->start("result final calculation time");
+
+        std::vector<long> final_excess;
+        if (this->result_evaluated) {
+            //the best cover of anytime WMA was matched already, the full matching is the most expensive step
+            this->logFacilityIndexes();
+            this->totalCost = this->best_cost;
+            final_excess = this->best_excess;
+        } else {
+            this->totalCost = this->evaluateResult(final_excess);
+        }
 
         //calculate number of fully capacitated nodes
         long capn = 0;
-        for (long i = this->source_indexes.size(); i < M.node_excess.size(); i++) {
-            capn += (M.node_excess[i] == 0);
+        for (long i = this->source_indexes.size(); i < final_excess.size(); i++) {
+            capn += (final_excess[i] == 0);
         }
-        logger->add1("full facilities", capn);
+        this->logger->add1("full facilities", capn);
 
-        logger->finish("result final calculation time");
-        logger->add("objective", totalCost);
+        this->logger->finish("result final calculation time");
+        this->logger->add("objective", totalCost);
         return this->totalCost;
     }
 
@@ -622,4 +1173,7 @@ public:
     }
 };
 
+typedef BasicFacilityChooser<long,long> FacilityChooser;
+typedef BasicFacilityChooser<int32_t,int32_t> FacilityChooser32; //half of the memory of matching, see Network::fits_types
+
 #endif //FCLA_FACILITYCHOOSER_H
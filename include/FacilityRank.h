@@ -9,15 +9,26 @@ struct FacilityRank {
 public:
     long coverage;
     long lastUsed;
+    long id;
+    //ties need a fixed total order: the coverage heap updated incrementally from changes of the matching must choose
+    //the same cover as a heap rebuilt from scratch, which is not the case if equal ranks come out in the order of
+    //their history in the heap. The order of ids is fixed but prefers neighbouring facilities, as ids follow the
+    //network, and needs more iterations on regular networks. So ids are scrambled by Fibonacci hashing, a bijection
+    unsigned long tie;
     FacilityRank() {}
-    FacilityRank(long c, long u) {
+    FacilityRank(long c, long u, long i = 0) {
         coverage = c;
         lastUsed = u;
+        id = i;
+        tie = (unsigned long) i * 0x9E3779B97F4A7C15UL;
     }
     ~FacilityRank() {}
 
     inline bool operator < (const FacilityRank& rhs) const {
         if (coverage == rhs.coverage) {
+            if (lastUsed == rhs.lastUsed) {
+                return tie > rhs.tie;
+            }
             return lastUsed > rhs.lastUsed; //more recently used is worse
         }
         return coverage < rhs.coverage;
@@ -25,6 +36,9 @@ public:
 
     inline bool operator > (const FacilityRank& rhs) const {
         if (coverage == rhs.coverage) {
+            if (lastUsed == rhs.lastUsed) {
+                return tie < rhs.tie;
+            }
             return lastUsed < rhs.lastUsed; //more recently used is worse
         }
         return coverage > rhs.coverage;
@@ -0,0 +1,51 @@
+/*
+ * Heap policies select the priority queue of a site: Dijkstra and global heaps of Matcher, Dijkstra heaps
+ * of the exploring edge generators and the coverage heap of FacilityChooser.
+ *
+ * A policy provides heap<V, I, Compare>, an indexed heap with the interface of fHeap (see nheap.h).
+ * RadixHeapPolicy is valid only for integer keys that are dequeued in a monotone order (Dijkstra in a network),
+ * BucketQueuePolicy only for the coverage heap (max-queue of FacilityRank).
+ * Policies are compared per site with heapbench (see heapbench.cpp).
+ */
+
+#ifndef FCLA_HEAPPOLICY_H
+#define FCLA_HEAPPOLICY_H
+
+#include <functional>
+
+#include "DaryHeap.h"
+#include "PairingHeap.h"
+#include "RadixHeap.h"
+#include "BucketQueue.h"
+
+template<unsigned D>
+struct DaryHeapPolicy {
+    template<class V, class I, class Compare = std::less<V>>
+    using heap = DaryHeap<V, I, D, Compare>;
+};
+
+typedef DaryHeapPolicy<2> BinaryHeapPolicy; //the same order of elements as fHeap
+
+struct PairingHeapPolicy {
+    template<class V, class I, class Compare = std::less<V>>
+    using heap = PairingHeap<V, I, Compare>;
+};
+
+struct RadixHeapPolicy {
+    template<class V, class I, class Compare = std::less<V>>
+    using heap = RadixHeap<V, I, Compare>;
+};
+
+struct BucketQueuePolicy {
+    template<class V, class I, class Compare = std::greater<V>>
+    using heap = BucketQueue<V, I, Compare>;
+};
+
+//defaults per site: the binary heap keeps the order of equal elements of fHeap, so results do not change.
+//FacilityRank has no equal elements (ties are broken by id), so every coverage policy picks the same facilities,
+//the bucket queue is the fastest one in heapbench
+typedef BinaryHeapPolicy MatcherHeapPolicy; //dheap and gheap of Matcher
+typedef BinaryHeapPolicy GeneratorHeapPolicy; //Dijkstra heaps of the exploring edge generators
+typedef BucketQueuePolicy CoverageHeapPolicy; //coverage heap of FacilityChooser
+
+#endif //FCLA_HEAPPOLICY_H
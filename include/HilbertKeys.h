@@ -0,0 +1,87 @@
+/*
+ * Hilbert curve order of points without comparisons of doubles.
+ *
+ * Coordinates are quantized once to 32 bits per axis in the bounding box of all points (the same scale
+ * for both axes, so distances keep their proportions) and converted to a 64-bit Hilbert index with hilbert_c2i.
+ * Points are then ordered by their indexes with an LSD radix sort, O(n) per pass instead of O(n log n) calls
+ * of hilbert_ieee_cmp. Network caches the indexes of its nodes, see Network::get_hilbert_keys.
+ */
+
+#ifndef FCLA_HILBERTKEYS_H
+#define FCLA_HILBERTKEYS_H
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+
+#include "Hilbert.h"
+
+#define HILBERT_BITS 32 //bits per coordinate, two coordinates fill a 64-bit index
+#define RADIX_BITS 8 //bits of a key sorted in one pass
+
+/*
+ * Hilbert index of every point, computed in parallel
+ */
+inline std::vector<uint64_t> compute_hilbert_keys(const std::vector<std::pair<double,double>>& coords) {
+    std::vector<uint64_t> keys(coords.size());
+    if (coords.empty()) {
+        return keys;
+    }
+    double min_x = coords[0].first;
+    double max_x = coords[0].first;
+    double min_y = coords[0].second;
+    double max_y = coords[0].second;
+    for (auto& point : coords) {
+        min_x = std::min(min_x, point.first);
+        max_x = std::max(max_x, point.first);
+        min_y = std::min(min_y, point.second);
+        max_y = std::max(max_y, point.second);
+    }
+    double span = std::max(max_x - min_x, max_y - min_y);
+    double scale = span > 0 ? ((double) ((1ULL << HILBERT_BITS) - 1)) / span : 0;
+    long count = coords.size();
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < count; i++) {
+        bitmask_t quantized[2];
+        quantized[0] = (bitmask_t) ((coords[i].first - min_x) * scale);
+        quantized[1] = (bitmask_t) ((coords[i].second - min_y) * scale);
+        keys[i] = hilbert_c2i(2, HILBERT_BITS, quantized);
+    }
+    return keys;
+}
+
+/*
+ * Stable LSD radix sort of (key, value) pairs by the key
+ * Histograms of all digits are counted in one pass, digits that are equal for all keys are skipped
+ */
+template<typename T>
+void radix_sort(std::vector<std::pair<uint64_t,T>>& entries) {
+    const int DIGITS = 64 / RADIX_BITS;
+    const uint64_t BUCKETS = 1ULL << RADIX_BITS;
+    std::vector<std::vector<size_t>> offsets(DIGITS, std::vector<size_t>(BUCKETS, 0));
+    for (auto& entry : entries) {
+        for (int digit = 0; digit < DIGITS; digit++) {
+            offsets[digit][(entry.first >> (digit * RADIX_BITS)) & (BUCKETS - 1)]++;
+        }
+    }
+    std::vector<std::pair<uint64_t,T>> buffer(entries.size());
+    for (int digit = 0; digit < DIGITS; digit++) {
+        std::vector<size_t>& offset = offsets[digit];
+        if (std::find(offset.begin(), offset.end(), entries.size()) != offset.end()) {
+            continue;
+        }
+        size_t sum = 0;
+        for (auto& bucket : offset) {
+            size_t bucket_size = bucket;
+            bucket = sum;
+            sum += bucket_size;
+        }
+        for (auto& entry : entries) {
+            buffer[offset[(entry.first >> (digit * RADIX_BITS)) & (BUCKETS - 1)]++] = entry;
+        }
+        entries.swap(buffer);
+    }
+}
+
+#endif //FCLA_HILBERTKEYS_H
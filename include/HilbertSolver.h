@@ -15,24 +15,31 @@
 #include "FacilityChooser.h"
 #include "igraph/igraph.h"
 #include "Logger.h"
-#include "Hilbert.h"
+#include "HilbertKeys.h"
 #include "TargetExploringEdgeGenerator.h"
+#include "AuctionMatcher.h"
 #include "exceptions.h"
 
-class HilbertSolver {
+/*
+ * Template types stand for < weight/potentials/cost type, node/edge index type > of the matching,
+ * see HilbertSolver and HilbertSolver32
+ */
+template<typename W, typename I>
+class BasicHilbertSolver {
 public:
 
     Logger* logger;
     Network* network;
     long facility_number_to_locate;
     long facility_capacity;
+    bool auction_objective = false; //if objective is calculated with AuctionMatcher instead of SIA
 
-    HilbertSolver(Network* net, Logger* logger) {
+    BasicHilbertSolver(Network* net, Logger* logger) {
         this->network = net;
         this->logger = logger;
     }
 
-    ~HilbertSolver() {
+    ~BasicHilbertSolver() {
 
     }
 
@@ -41,19 +48,6 @@ public:
         long index;
     };
 
-    struct ComparatorHilbertEntry
-    {
-        bool operator()(const Customer& r1, const Customer& r2)
-        {
-            double d1[2],d2[2];
-            d1[0] = r1.coords.first;
-            d1[1] = r1.coords.second;
-            d2[0] = r2.coords.first;
-            d2[1] = r2.coords.second;
-            return hilbert_ieee_cmp(2,d1,d2) >= 0;
-        }
-    } hilbert_comparator;
-
     inline double get_dist(Coords& c1, Coords& c2)
     {
         return sqrt(pow(c1.first-c2.first,2) + pow(c1.second-c2.second,2));
@@ -91,7 +85,16 @@ public:
         std::vector<long> facility_locations;
         if (customers.size() == 0 || facility_count == 0) return facility_locations;
 
-        std::sort(customers.begin(), customers.end(), hilbert_comparator);
+        //order along the Hilbert curve by the keys cached on the network
+        const std::vector<uint64_t>& keys = network->get_hilbert_keys();
+        std::vector<std::pair<uint64_t, Customer>> ordered;
+        for (auto& customer : customers) {
+            ordered.push_back(std::make_pair(keys[customer.index], customer));
+        }
+        radix_sort(ordered);
+        for (long i = 0; i < customers.size(); i++) {
+            customers[i] = ordered[i].second;
+        }
 
         std::vector<long> splitting_indexes = equally_splitting_indexes(customers.size(), facility_count);
         for (long i = 0; i < facility_count; i++) {
@@ -271,8 +274,14 @@ public:
             }
         }
 
-        TargetExploringEdgeGenerator<long,long> edge_generator(*network, only_target_facility_node_indexes);
-        Matcher<long,long,long> M(&edge_generator, new_excess, logger);
+        TargetExploringEdgeGenerator<I,W> edge_generator(*network, only_target_facility_node_indexes);
+        if (this->auction_objective) {
+            AuctionMatcher<long,W,I> A(&edge_generator, new_excess, logger);
+            A.match();
+            A.calculateResult();
+            return A.result_weight;
+        }
+        Matcher<long,W,I> M(&edge_generator, new_excess, logger);
         M.match();
         M.calculateResult();
         return M.result_weight;
@@ -305,4 +314,7 @@ public:
     }
 };
 
+typedef BasicHilbertSolver<long,long> HilbertSolver;
+typedef BasicHilbertSolver<int32_t,int32_t> HilbertSolver32; //half of the memory of matching, see Network::fits_types
+
 #endif //FCLA_HILBERTSOLVER_H
@@ -0,0 +1,97 @@
+/*
+ * Monotonic memory arena for structures that live for one WMA iteration.
+ *
+ * Memory is handed out by bumping an offset inside large blocks and is never freed separately.
+ * reset() makes all blocks available again at once, blocks stay allocated for the next iteration,
+ * so after the first iterations no allocator calls happen at all.
+ *
+ * Only for trivially copyable types: no constructors or destructors are called.
+ */
+
+#ifndef FCLA_ITERATIONARENA_H
+#define FCLA_ITERATIONARENA_H
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstddef>
+
+class IterationArena {
+public:
+    IterationArena(size_t block_size = 1 << 20) {
+        this->block_size = block_size;
+        this->current_block = 0;
+        this->offset = 0;
+        this->used = 0;
+    }
+    ~IterationArena() {}
+
+    /*
+     * Uninitialized array of <count> elements
+     */
+    template<typename T>
+    T* allocate(size_t count) {
+        return static_cast<T*>(allocate_bytes(count * sizeof(T), alignof(T)));
+    }
+
+    template<typename T>
+    T* allocate(size_t count, T value) {
+        T* result = allocate<T>(count);
+        std::fill(result, result + count, value);
+        return result;
+    }
+
+    /*
+     * Forget all allocations, all previously returned pointers become invalid
+     */
+    void reset() {
+        current_block = 0;
+        offset = 0;
+        used = 0;
+    }
+
+    size_t bytes_used() const {
+        return used;
+    }
+
+    size_t bytes_reserved() const {
+        size_t total = 0;
+        for (auto& block : blocks) {
+            total += block.size;
+        }
+        return total;
+    }
+
+private:
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+    std::vector<Block> blocks;
+    size_t block_size;
+    size_t current_block;
+    size_t offset; //first free byte in the current block
+    size_t used;
+
+    void* allocate_bytes(size_t bytes, size_t alignment) {
+        while (true) {
+            if (current_block == blocks.size()) {
+                //blocks from new[] are aligned for any fundamental type
+                Block block;
+                block.size = std::max(block_size, bytes);
+                block.data.reset(new char[block.size]);
+                blocks.push_back(std::move(block));
+            }
+            size_t start = (offset + alignment - 1) / alignment * alignment;
+            if (start + bytes <= blocks[current_block].size) {
+                offset = start + bytes;
+                used += bytes;
+                return blocks[current_block].data.get() + start;
+            }
+            current_block++;
+            offset = 0;
+        }
+    }
+};
+
+#endif //FCLA_ITERATIONARENA_H
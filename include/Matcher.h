@@ -11,35 +11,38 @@
 
 #include <string>
 #include <vector>
-#include <forward_list>
 #include <igraph/igraph.h>
 #include <limits>
 #include <algorithm>
 #include <stdexcept>
 #include <utility>
+#include <atomic>
 
-#include "nheap.h"
+#include "HeapPolicy.h"
+#include "ResidualGraph.h"
 #include "helpers.h"
+#include "Network.h"
 #include "EdgeGenerator.h"
 #include "TargetExploringEdgeGenerator.h"
 #include "Logger.h"
 #include "exceptions.h"
-#include "Hilbert.h"
+#include "HilbertKeys.h"
 
 /*
  * Template types stand for
- * < flow/supply type, weight/potentials/cost type, node/edge index type >
+ * < flow/supply type, weight/potentials/cost type, node/edge index type, heap policy (see HeapPolicy.h) >
  */
-template<typename F, typename W, typename I>
+template<typename F, typename W, typename I, typename H = MatcherHeapPolicy>
 class Matcher {
 public:
     const W INF_W = std::numeric_limits<W>::max();
-    const W VERY_BIG_W = 1000000; // weight for uncapacitated-case extra node
-    //bigraph as two linked lists, storing only non-full edges
+    const W VERY_BIG_W = EXTRA_NODE_WEIGHT; // weight for uncapacitated-case extra node
+    const long BATCH_MIN_FLOW_SHARE = 2; // batched matching continues while a phase matches at least half of the sources
+    //residual bigraph, storing only non-full edges
     typedef std::pair<I,W> Edge;
-    typedef std::forward_list<Edge> Adjlist;
-    typedef typename Adjlist::iterator EdgeIterator;
-    std::vector<Adjlist> edges; // decreasing order of weights
+    typedef typename ResidualGraph<I,W>::Arcs Adjlist;
+    typedef typename ResidualGraph<I,W>::ArcIterator EdgeIterator;
+    ResidualGraph<I,W> edges;
     std::vector<std::vector<Edge>> backwards_edges; //for greedy, increasing order
     std::vector<F> node_excess;
     std::vector<F> full_node_excess;
@@ -49,9 +52,17 @@ public:
     Logger* logger;
     bool allow_extra_node_assignment;
     bool greedyMatching = false;
+    bool batchedMatching = false; //match all customers with negative excess together, see matchBatched
+    bool warmStartMatching = false; //try paths of zero reduced cost arcs before Dijkstra, see matchVertex
+    long warmStartArcBudget = 256; //arcs tried by the zero path search of the warm start before Dijkstra runs
+    double epsilon = 0; //accept augmenting paths up to (1+epsilon) times longer than the shortest one, see ifValidTarget
+    long added_edges = 0; //edges taken from the generator into the bipartite graph
+    long shortest_path_searches = 0; //Dijkstra runs of matchVertex and matchPhase
     bool hilbert_is_ready = false;
     std::vector<long> hilbert_order;
     int greedyMatchingOrder = 0;
+    long greedyChunk = 0; //customers per parallel chunk of greedy matching, 0 - sequential, see matchGreedyParallel
+    bool greedyDeterministic = true; //parallel greedy gives the result of the sequential one, see matchGreedyParallel
 
     //handle uncapacitated case
     std::vector<bool> extra_edge_added_per_source;
@@ -65,8 +76,22 @@ public:
     //local variables (preserve only for one iteration)
     std::vector<W> mindist;
     std::vector<I> backtrack;
-    fHeap<W,I> dheap;
-    fHeap<W,I> gheap; //@todo what about enheaping the first node? what about dist of all nodes of dheap between iterations?
+    std::vector<I> backtrack_arc; //position of the arc backtrack[v]->v in edges[backtrack[v]]
+    std::vector<I> touched_nodes; //nodes with finite mindist in the current iteration, the rest are kept at INF
+
+    //local variables of batched matching and warm start (preserve only for one phase)
+    std::vector<long> phase_visited; //id of the last phase that visited a node, so marks are never reset
+    long phase_id;
+    std::vector<I> dfs_arc; //position of the next arc to try in the depth-first search
+    std::vector<I> dfs_path;
+
+    //edges indexed by source and by target for dynamic updates, built at the first one, see buildEdgeIndex
+    bool edge_index_ready = false;
+    std::vector<std::vector<I>> source_targets; //targets of the edges of a source
+    std::vector<std::vector<Edge>> target_sources; //sources and weights of the edges into a target
+
+    typename H::template heap<W,I> dheap;
+    typename H::template heap<W,I> gheap; //@todo what about enheaping the first node? what about dist of all nodes of dheap between iterations?
 
     //arrays with results
     W result_weight;
@@ -80,6 +105,13 @@ public:
         }
     }
 
+    /*
+     * If ids and distances of a matching on the network fit into the types of this matcher, see Network::fits_types
+     */
+    static bool fitsNetwork(Network& network) {
+        return network.fits_types<I,W>();
+    }
+
     I inline getExtraNodeIndex() {
         return this->node_excess.size()-1;
     }
@@ -87,12 +119,13 @@ public:
     void reset() {
         total_matched.clear();
         total_matched.resize(source_count, 0);
+        added_edges = 0;
 
         potentials.resize(graph_size, 0);
         edges.resize(graph_size);
+        edges.clear();
         backwards_edges.resize(graph_size);
         for (I i = 0; i < graph_size; i++) {
-            edges[i].clear();
             backwards_edges[i].clear();
         }
 
@@ -115,8 +148,18 @@ public:
             new_edges.push_back(e);
         }
 
-        mindist.resize(graph_size);
-        backtrack.resize(graph_size);
+        mindist.assign(graph_size, INF_W);
+        backtrack.assign(graph_size, -1);
+        backtrack_arc.resize(graph_size);
+        touched_nodes.clear();
+
+        phase_visited.assign(graph_size, -1);
+        phase_id = 0;
+        dfs_arc.resize(graph_size);
+
+        edge_index_ready = false;
+        source_targets.clear();
+        target_sources.clear();
     }
 
     //for Facility Location inheritance
@@ -130,7 +173,7 @@ public:
         this->allow_extra_node_assignment = allow_extra_node_assignment;
 
         // extra node must have enough excess to serve all nodes, consider multicomponent graph
-        this->node_excess.push_back(std::numeric_limits<long>::max()); // big number goes from the fact that later we can increase demads of customers
+        this->node_excess.push_back(std::numeric_limits<F>::max()); // big number goes from the fact that later we can increase demads of customers
 
         this->logger = logger;
         reset();
@@ -157,8 +200,29 @@ public:
         return mindist[source_id] + new_edge_w - potentials[source_id];
     }
 
-    inline bool ifValidTarget(W distance) {
-        return distance < this->gheap.getTopValue();
+    /*
+     * Reduced cost of an arc for Dijkstra: arcs of accepted approximate paths may have negative reduced costs,
+     * they are taken as zero, so Dijkstra stays label-setting. The exact mode uses reduced costs as they are
+     */
+    inline W searchCost(W weight, I source_id, I target_id)
+    {
+        W cost = edgeCost(weight, source_id, target_id);
+        return cost < 0 && this->epsilon > 0 ? 0 : cost;
+    }
+
+    /*
+     * If a path of the given length is good enough, or an edge should be added from the global heap first
+     *
+     * With a positive tolerance a path is accepted if it is at most (1+tolerance) times longer than the lower bound
+     * of any path through a not generated edge (the top of the global heap), so fewer edges are generated
+     */
+    inline bool ifValidTarget(W distance, double tolerance = 0) {
+        //an empty global heap has no top value, and there is no edge to add anyway
+        if (this->gheap.size() == 0) {
+            return true;
+        }
+        W bound = this->gheap.getTopValue();
+        return distance < bound || (tolerance > 0 && bound > 0 && distance < bound + (W) (tolerance * bound));
     }
 
     /*
@@ -168,6 +232,9 @@ public:
     {
         W cur_dist = mindist[v_id];
         if (cur_dist > new_distance) {
+            if (cur_dist == INF_W) {
+                touched_nodes.push_back(v_id);
+            }
             mindist[v_id] = new_distance;
             return true;
         }
@@ -176,22 +243,39 @@ public:
 
     /*
      * Initialize vectors and variables for Dijkstra
+     *
+     * Only nodes touched by the previous iteration are reset, so the cost does not depend on the graph size
      */
     void iteration_init(I source_id)
+    {
+        iteration_clear();
+        iteration_add_source(source_id);
+    }
+
+    void iteration_clear()
     {
         //init heaps
-        gheap.clear(); //global heap stores information of the next not-added neighbor of vertices
-        dheap.clear(); //heap used in Dijkstra
+        gheap.softClear(); //global heap stores information of the next not-added neighbor of vertices
+        dheap.softClear(); //heap used in Dijkstra
 
-        //initialize heaps and vectors according to a source node
-        std::fill(mindist.begin(),mindist.end(), INF_W);
-        mindist[source_id] = 0;
+        for (auto node : touched_nodes) {
+            mindist[node] = INF_W;
+            backtrack[node] = -1;
+        }
+        touched_nodes.clear();
+    }
 
-        std::fill(backtrack.begin(), backtrack.end(), -1);
+    /*
+     * Start Dijkstra from one more source node with a given initial distance
+     */
+    void iteration_add_source(I source_id, W distance = 0)
+    {
+        mindist[source_id] = distance;
         backtrack[source_id] = source_id;
+        touched_nodes.push_back(source_id);
 
         //enqueue first node into Dijktra heap
-        dheap.enqueue(source_id, 0);
+        dheap.enqueue(source_id, distance);
     }
 
     /*
@@ -211,13 +295,15 @@ public:
                 return current_node; //already contains correct path distance in both backtrack and mindist arrays
             }
             //update minimum distances to all neighbors
-            for (EdgeIterator it = edges[current_node].begin(); it != edges[current_node].end(); it++) {
+            Adjlist& out_edges = edges[current_node];
+            for (I position = 0; position < out_edges.size(); position++) {
                 W new_cost = mindist[current_node];
-                I target_node = it->first;
-                new_cost += edgeCost(it->second, current_node, target_node);
+                I target_node = out_edges[position].first;
+                new_cost += searchCost(out_edges[position].second, current_node, target_node);
                 if (updateMindist(target_node, new_cost)) {
                     //update breadcrumbs
                     backtrack[target_node] = current_node;
+                    backtrack_arc[target_node] = position;
                     //update or enqueue target node
                     dheap.updateorenqueue(target_node, new_cost);
                     //maintain global heap (value for target_node was changed because of mindist
@@ -239,7 +325,11 @@ public:
     void addNewEdge(newEdge new_edge)
     {
         //add a new edge
-        edges[new_edge.source_node].push_front(std::make_pair(new_edge.target_node, new_edge.weight));
+        edges.addArc(new_edge.source_node, new_edge.target_node, new_edge.weight);
+        added_edges++;
+        if (edge_index_ready) {
+            indexEdge(new_edge.source_node, new_edge.target_node, new_edge.weight);
+        }
 
 
         //updating Dijkstra heap by adding source_node to a heap:
@@ -298,10 +388,11 @@ public:
      * Run dijkstra and enlarge graph until a valid path to non-full vertex to type B appears
      *
      * Since there is an extra node, the source node will be matched to at least one as a result
+     * A positive tolerance accepts approximate paths, see ifValidTarget
      *
      * Return false if no path exists
      */
-    long runHeapDijkstraAndEnlargeBGraph()
+    long runHeapDijkstraAndEnlargeBGraph(double tolerance = 0)
     {
         long target_id = -1;
         while (target_id == -1) {
@@ -313,7 +404,7 @@ public:
             } else {
                 W sp_length = mindist[target_id];
                 //check threshold
-                if (!ifValidTarget(sp_length) && addHeapedEdge()) {
+                if (!ifValidTarget(sp_length, tolerance) && addHeapedEdge()) {
                     target_id = -1; //invalidate result if new edge is added, otherwise return current result
                 }
             }
@@ -325,14 +416,22 @@ public:
      * Update potentials for all visited nodes
      *
      * Maintain potentials so that there are no negative weights: new = old + (dist[target] - dist[current])
-     * Do it for all nodes where dist < dist[target] (mindist), finding nodes by BFS
+     * Do it for all nodes where dist < dist[target] (mindist). Such nodes were settled by dijkstra in this
+     * iteration, so they are all in touched_nodes; every other node has infinite distance and is skipped
+     *
+     * An approximate path may be longer than the top of the global heap, then the potentials are raised only
+     * up to the top, so that the edges which are not generated yet keep non-negative reduced costs.
+     * For an exact path the top is always longer, so it changes nothing
      */
     void updatePotentials(I target)
     {
         W target_distance = mindist[target];
-        for (I i = 0; i < graph_size; i++) {
-            if (mindist[i] < target_distance) {
-                potentials[i] = potentials[i] + target_distance - mindist[i];
+        if (gheap.size() > 0 && gheap.getTopValue() < target_distance) {
+            target_distance = gheap.getTopValue();
+        }
+        for (auto node : touched_nodes) {
+            if (mindist[node] < target_distance) {
+                potentials[node] = potentials[node] + target_distance - mindist[node];
             }
         }
     }
@@ -343,6 +442,9 @@ public:
      * - Inverted edges already must exist in the graph
      * - Ignore heap values as they will not be used anymore
      *
+     * Arcs of the path are found by positions saved in dijkstra. Each node of the path loses one arc
+     * before it gets the inverted one, and arcs are only appended between dijkstra and this call,
+     * so the saved positions are still valid when they are used.
      */
     F augmentFlow(I target)
     {
@@ -358,32 +460,10 @@ public:
 
         //iterate throw forward path and reassign edges to the opposite nodes (flip them)
         while (backtrack[current_node] != current_node) {
-            //find an edge in adj list
             I target_node = current_node; //note this! we are back-propagating
             I source_node = backtrack[current_node];
-
-            //find an edge
-            EdgeIterator it = edges[source_node].begin();
-            //we should erase *it, change weight to the opposite and assign to target
-            //note that linked list has only "remove after" operation
-            W weight;
-            if (it->first == target_node) {
-                weight = -it->second;
-                edges[source_node].pop_front();
-            } else {
-                EdgeIterator prev_it = it;
-                it++;
-                while(true) { //strong assumption on graph structure consistency
-                    if (it->first == target_node) {
-                        break;
-                    }
-                    prev_it = it;
-                    it++;
-                }
-                weight = -it->second;
-                edges[source_node].erase_after(prev_it);
-            }
-            edges[target_node].push_front(std::make_pair(source_node,weight));
+            assert(edges[source_node][backtrack_arc[target_node]].first == target_node);
+            edges.flipArc(source_node, backtrack_arc[target_node]);
             current_node = source_node;
         }
 
@@ -409,7 +489,20 @@ public:
         if (node_excess[source_id] >= 0)
             throw std::logic_error("Only nodes with negative excess can be matched");
 
+        //the arcs of zero reduced cost contain the shortest path trees of all previous iterations: potentials
+        //persist and flipped arcs keep zero cost. A path of them to a non-full vertex has the minimal distance 0,
+        //so it is a shortest augmenting path and the potentials do not change. A miss is paid on top of Dijkstra,
+        //so the search gives up after a budget of arcs
+        if (this->warmStartMatching) {
+            phase_id++;
+            I target = findZeroPath(source_id, this->warmStartArcBudget);
+            if (target != -1) {
+                return augmentFlow(target);
+            }
+        }
+
         this->iteration_init(source_id);
+        shortest_path_searches++;
 
         //nearest_edges array is global, but gheap is local. In order to descrease heap size we enheap
         //only those nodes which were visited by the algorithm (relevant)
@@ -419,7 +512,7 @@ public:
             gheap.enqueue(source_id, heapedCost(new_edges[source_id].weight, source_id));
 
         //enlarge graph until valid path is found, or throw an exception
-        long result_vid = runHeapDijkstraAndEnlargeBGraph();
+        long result_vid = runHeapDijkstraAndEnlargeBGraph(this->epsilon);
 
         F flowChange = augmentFlow(result_vid);
         updatePotentials(result_vid);
@@ -427,6 +520,170 @@ public:
         return flowChange;
     }
 
+    /*
+     * Find shortest augmenting paths for many source vertices at once (one phase of batched matching)
+     *
+     * Dijkstra starts from all given sources at once, as if there was a super-source connected to them,
+     * and stops at the closest non-full vertex, the graph is enlarged the same way as in matchVertex.
+     * After the potential update every arc on a shortest path from the super-source has zero reduced cost,
+     * and since the potentials stay valid for the edges that are not generated yet, any path of zero arcs
+     * from a source to a non-full vertex is a shortest augmenting path. Such paths are augmented one by one
+     * while they are vertex-disjoint: flipped arcs keep zero reduced cost, so the matching stays optimal after each.
+     * Only the end of a path may be shared: a facility with capacity left stays open for other sources of the phase.
+     *
+     * Potentials stay valid for any initial distances of the sources, they only decide which sources get
+     * a zero path in this phase. Each source starts at minus the reduced cost of its cheapest outgoing arc,
+     * so all sources whose closest non-full vertex is their direct neighbor are augmented in the same phase.
+     *
+     * Paths of a phase are always exact, epsilon is used by matchVertex only. After approximate paths some arcs
+     * may have negative reduced costs and a phase may match nothing, then matchBatched falls back to matchVertex.
+     *
+     * Returns flow change, at least one in the exact mode. Throws NoMoreEdgesToAdd if none of the sources has a path
+     */
+    F matchPhase(std::vector<I>& source_ids)
+    {
+        this->iteration_clear();
+        shortest_path_searches++;
+        for (auto source_id : source_ids) {
+            this->iteration_add_source(source_id, -cheapestOutgoingCost(source_id));
+            if (new_edges[source_id].exists)
+                gheap.enqueue(source_id, heapedCost(new_edges[source_id].weight, source_id));
+        }
+
+        long result_vid = runHeapDijkstraAndEnlargeBGraph();
+        updatePotentials(result_vid);
+
+        //depth-first search over zero arcs, each node is visited at most once per phase
+        phase_id++;
+        F flowChange = 0;
+        for (auto source_id : source_ids) {
+            if (phase_visited[source_id] == phase_id || node_excess[source_id] >= 0) {
+                continue;
+            }
+            I target = findZeroPath(source_id);
+            if (target != -1) {
+                flowChange += augmentFlow(target);
+                if (node_excess[target] > 0) {
+                    phase_visited[target] = phase_id - 1; //still not full, other sources of the phase may end there too
+                }
+            }
+        }
+        return flowChange;
+    }
+
+    /*
+     * Lower bound of the reduced cost of any path from a node: its cheapest arc or the next edge to be generated
+     * (potentials are never negative). Zero if there is nothing to leave the node with
+     */
+    W cheapestOutgoingCost(I node)
+    {
+        W min_cost = INF_W;
+        if (node < this->source_count && new_edges[node].exists) {
+            min_cost = new_edges[node].weight - potentials[node];
+        }
+        Adjlist& out_edges = edges[node];
+        for (I position = 0; position < out_edges.size(); position++) {
+            min_cost = std::min(min_cost, edgeCost(out_edges[position].second, node, out_edges[position].first));
+        }
+        return min_cost == INF_W ? 0 : min_cost;
+    }
+
+    /*
+     * Search for a path of zero reduced cost arcs to a non-full vertex through nodes not visited in this phase
+     * The path is stored in backtrack and backtrack_arc, as for augmentFlow. Returns -1 if there is no path
+     * or it is not found after trying <arc_budget> arcs
+     */
+    I findZeroPath(I source_id, long arc_budget = std::numeric_limits<long>::max())
+    {
+        dfs_path.clear();
+        dfs_path.push_back(source_id);
+        phase_visited[source_id] = phase_id;
+        backtrack[source_id] = source_id;
+        dfs_arc[source_id] = 0;
+        while (!dfs_path.empty()) {
+            I current_node = dfs_path.back();
+            if (current_node != source_id && node_excess[current_node] > 0) {
+                return current_node;
+            }
+            Adjlist& out_edges = edges[current_node];
+            bool advanced = false;
+            while (dfs_arc[current_node] < out_edges.size()) {
+                if (arc_budget-- == 0) {
+                    return -1;
+                }
+                I position = dfs_arc[current_node]++;
+                I target_node = out_edges[position].first;
+                if (phase_visited[target_node] == phase_id ||
+                    edgeCost(out_edges[position].second, current_node, target_node) != 0) {
+                    continue;
+                }
+                phase_visited[target_node] = phase_id;
+                backtrack[target_node] = current_node;
+                backtrack_arc[target_node] = position;
+                dfs_arc[target_node] = 0;
+                dfs_path.push_back(target_node);
+                advanced = true;
+                break;
+            }
+            if (!advanced) {
+                dfs_path.pop_back(); //dead end, stays visited
+            }
+        }
+        return -1;
+    }
+
+    /*
+     * Match all source vertices with negative excess, one multi-source Dijkstra per phase instead of one per unit of demand
+     *
+     * Phases are cheap while most sources find a free neighbor, but when few paths remain each phase still
+     * explores the neighborhoods of all sources. When a phase matches less than a share of the sources,
+     * the rest is matched one by one with matchVertex.
+     *
+     * Sources that can not be matched anymore (no more edges to add) get their excess back to zero and are returned
+     */
+    std::vector<I> matchBatched()
+    {
+        std::vector<I> source_ids;
+        for (I i = 0; i < source_count; i++) {
+            if (node_excess[i] < 0) {
+                source_ids.push_back(i);
+            }
+        }
+        std::vector<I> unmatched_sources;
+        F flowChange = source_ids.size();
+        while (!source_ids.empty() && flowChange * BATCH_MIN_FLOW_SHARE >= source_ids.size()) {
+            try {
+                flowChange = matchPhase(source_ids);
+            } catch (NoMoreEdgesToAdd& e) {
+                //none of the remaining sources has a path
+                for (auto source_id : source_ids) {
+                    node_excess[source_id] = 0;
+                }
+                unmatched_sources.swap(source_ids);
+                return unmatched_sources;
+            }
+            //keep only sources with remaining demand
+            I remaining = 0;
+            for (auto source_id : source_ids) {
+                if (node_excess[source_id] < 0) {
+                    source_ids[remaining++] = source_id;
+                }
+            }
+            source_ids.resize(remaining);
+        }
+        for (auto source_id : source_ids) {
+            try {
+                while (node_excess[source_id] < 0) {
+                    matchVertex(source_id);
+                }
+            } catch (NoMoreEdgesToAdd& e) {
+                node_excess[source_id] = 0;
+                unmatched_sources.push_back(source_id);
+            }
+        }
+        return unmatched_sources;
+    }
+
     /*
      * Run matching algorithm on a bipartite graph with vcountA,vcountB number of vertices of two types
      *
@@ -437,6 +694,12 @@ public:
             this->matchGreedy();
             return;
         }
+        if (this->batchedMatching) {
+            if (!this->matchBatched().empty()) {
+                throw no_more_edges_to_add_exception;
+            }
+            return;
+        }
 
         I source_id = 0;
         I prev_id = -1;
@@ -470,51 +733,219 @@ public:
                 this->makeRandomSourceOrder(source_ids);
                 break;
         }
-        for (auto it = source_ids.begin(); it != source_ids.end(); it++) {
-            if (!this->matchToClosestAvailableFacility(*it)) {
-                explored_sources.push_back((*it));
+        if (this->greedyChunk > 0) {
+            this->matchGreedyParallel(source_ids, explored_sources);
+        } else {
+            for (auto it = source_ids.begin(); it != source_ids.end(); it++) {
+                if (!this->matchToClosestAvailableFacility(*it)) {
+                    explored_sources.push_back((*it));
+                }
             }
         }
         logger->finish("greedyMatching");
         return explored_sources;
     }
 
-    void makeRandomSourceOrder(std::vector<long>& sources) {
-        std::random_shuffle(sources.begin(), sources.end());
+    /*
+     * Facilities chosen by one customer of a parallel greedy chunk
+     */
+    struct GreedyChoice {
+        std::vector<std::pair<long,W>> facilities;
+        long traversal; //steps over facilities, as closestFacility of matchToClosestAvailableFacility
+        bool needs_edges; //all generated edges were walked, the rest is matched sequentially
+        long conflicts; //claims lost to other customers
+        W conflict_detour; //extra weight over the facilities lost to other customers, see matchGreedyParallel
+    };
+
+    /*
+     * Greedy matching in chunks of greedyChunk customers along the order, customers of a chunk are processed
+     * in parallel (OpenMP). Edge generators are not thread safe, so customers that walked all their generated
+     * edges are finished sequentially, as in AuctionMatcher.
+     *
+     * Deterministic mode: every customer proposes its closest available facilities as of the start of the chunk,
+     * then proposals are committed in the order of customers. Capacities only decrease, so the facilities skipped
+     * as full are still full, and a proposal whose facilities are still available is exactly the choice of
+     * the sequential greedy. Other customers (conflicts) are matched sequentially at their turn.
+     * The result is the one of the sequential greedy for any number of threads.
+     *
+     * Otherwise facility capacities are claimed with atomic decrements and a customer that loses a claim
+     * retries with the next facility, the result depends on the scheduling. The conflict detour is the extra weight
+     * paid by customers over the facilities they lost. It is not a bound on the difference to the sequential
+     * greedy: a lost facility changes the choices of customers later in the order, which are not counted.
+     * Remaining capacities are loaded once and follow the claims and the sequential matching of the fallback.
+     */
+    void matchGreedyParallel(std::vector<long>& source_ids, std::vector<long>& explored_sources) {
+        long conflicts = 0;
+        W conflict_detour = 0;
+        std::vector<GreedyChoice> choices;
+        std::vector<std::atomic<long>> remaining(this->greedyDeterministic ? 0 : this->graph_size);
+        if (!this->greedyDeterministic) {
+            for (long i = this->source_count; i < this->graph_size; i++) {
+                remaining[i].store(this->node_excess[i], std::memory_order_relaxed);
+            }
+        }
+        for (long start = 0; start < source_ids.size(); start += this->greedyChunk) {
+            long chunk_size = std::min((long) source_ids.size() - start, this->greedyChunk);
+            choices.resize(chunk_size);
+            if (this->greedyDeterministic) {
+                #pragma omp parallel for schedule(dynamic, 64)
+                for (long k = 0; k < chunk_size; k++) {
+                    proposeGreedyChoice(source_ids[start + k], choices[k]);
+                }
+            } else {
+                #pragma omp parallel for schedule(dynamic, 64)
+                for (long k = 0; k < chunk_size; k++) {
+                    claimGreedyChoice(source_ids[start + k], choices[k], remaining);
+                }
+            }
+
+            //commit in the order of customers
+            for (long k = 0; k < chunk_size; k++) {
+                long source_id = source_ids[start + k];
+                GreedyChoice& choice = choices[k];
+                if (this->node_excess[source_id] == 0) {
+                    continue;
+                }
+                if (this->greedyDeterministic) {
+                    bool valid = !choice.needs_edges;
+                    for (auto& facility : choice.facilities) {
+                        valid = valid && !this->ifTargetCapacitated(facility.first);
+                    }
+                    if (!valid) {
+                        conflicts += !choice.needs_edges;
+                        if (!this->matchToClosestAvailableFacility(source_id)) {
+                            explored_sources.push_back(source_id);
+                        }
+                        continue;
+                    }
+                }
+                //claimed capacities were reserved atomically, so they are still available
+                for (auto& facility : choice.facilities) {
+                    edges.addArc(facility.first, source_id, -facility.second);
+                    node_excess[source_id]++;
+                    node_excess[facility.first]--;
+                }
+                conflicts += choice.conflicts;
+                conflict_detour += choice.conflict_detour;
+                if (!choice.needs_edges) {
+                    logger->add(std::string("furthest traversal ") + std::to_string(source_id), choice.traversal);
+                }
+            }
+            //claiming customers without enough generated edges are matched by the sequential greedy
+            //after all claims of the chunk are committed, since it does not see the reservations
+            if (!this->greedyDeterministic) {
+                for (long k = 0; k < chunk_size; k++) {
+                    long source_id = source_ids[start + k];
+                    if (!choices[k].needs_edges) {
+                        continue;
+                    }
+                    if (!this->matchToClosestAvailableFacility(source_id)) {
+                        explored_sources.push_back(source_id);
+                    }
+                    //the facilities taken are among the generated edges of the customer
+                    for (auto& facility : backwards_edges[source_id]) {
+                        remaining[facility.first].store(this->node_excess[facility.first], std::memory_order_relaxed);
+                    }
+                }
+            }
+        }
+        logger->add("greedy conflicts", conflicts);
+        logger->add("greedy conflict detour", conflict_detour);
     }
 
-    struct Customer {
-        Coords coords;
-        long index;
-    };
+    /*
+     * Closest facilities of a customer that are not full, among the generated edges, for the whole demand
+     * Reads capacities only, safe to run in parallel for different customers
+     */
+    void proposeGreedyChoice(long source_id, GreedyChoice& choice) {
+        choice.facilities.clear();
+        choice.traversal = 0;
+        choice.needs_edges = false;
+        choice.conflicts = 0;
+        choice.conflict_detour = 0;
+        F demand = -this->node_excess[source_id];
+        auto it = backwards_edges[source_id].begin();
+        while (choice.facilities.size() < demand) {
+            while (it != backwards_edges[source_id].end() && this->ifTargetCapacitated(it->first)) {
+                choice.traversal++;
+                it++;
+            }
+            if (it == backwards_edges[source_id].end()) {
+                choice.needs_edges = true;
+                return;
+            }
+            choice.facilities.push_back(*it);
+            it++;
+        }
+    }
 
-    struct ComparatorHilbertEntry
-    {
-        bool operator()(const Customer& r1, const Customer& r2)
-        {
-            double d1[2],d2[2];
-            d1[0] = r1.coords.first;
-            d1[1] = r1.coords.second;
-            d2[0] = r2.coords.first;
-            d2[1] = r2.coords.second;
-            return hilbert_ieee_cmp(2,d1,d2) >= 0;
+    /*
+     * Claim capacities of the closest facilities of a customer among the generated edges with atomic decrements,
+     * a failed claim is given back and the next facility is tried. If the generated edges are not enough,
+     * all claims are given back, the customer is matched sequentially. Safe to run in parallel for different customers
+     */
+    void claimGreedyChoice(long source_id, GreedyChoice& choice, std::vector<std::atomic<long>>& remaining) {
+        choice.facilities.clear();
+        choice.traversal = 0;
+        choice.needs_edges = false;
+        choice.conflicts = 0;
+        choice.conflict_detour = 0;
+        F demand = -this->node_excess[source_id];
+        bool lost = false;
+        W lost_weight = 0;
+        auto it = backwards_edges[source_id].begin();
+        while (choice.facilities.size() < demand) {
+            if (it == backwards_edges[source_id].end()) {
+                for (auto& facility : choice.facilities) {
+                    remaining[facility.first].fetch_add(1);
+                }
+                choice.facilities.clear();
+                choice.needs_edges = true;
+                return;
+            }
+            if (remaining[it->first].load(std::memory_order_relaxed) <= 0) {
+                choice.traversal++;
+            } else if (remaining[it->first].fetch_sub(1) > 0) {
+                choice.facilities.push_back(*it);
+                if (lost) {
+                    choice.conflict_detour += it->second - lost_weight;
+                    lost = false;
+                }
+            } else {
+                //another customer took the last unit in between
+                remaining[it->first].fetch_add(1);
+                choice.traversal++;
+                choice.conflicts++;
+                if (!lost) {
+                    lost = true;
+                    lost_weight = it->second;
+                }
+            }
+            it++;
         }
-    } hilbert_comparator;
+    }
+
+    void makeRandomSourceOrder(std::vector<long>& sources) {
+        std::random_shuffle(sources.begin(), sources.end());
+    }
 
+    /*
+     * Customers sorted by Hilbert indexes of their nodes, cached on the network, see HilbertKeys.h
+     */
     void makeHilbertSourceOrder(std::vector<long>& sources) {
         if (this->hilbert_is_ready) {
             sources = this->hilbert_order;
             return;
         }
-        std::vector<Customer> customers;
+        const std::vector<uint64_t>& keys = this->network->get_hilbert_keys();
+        std::vector<std::pair<uint64_t, long>> customers;
         for (auto s : sources) {
-            Coords coords = this->getCustomerCoords(s);
-            customers.push_back({coords, s});
+            customers.push_back(std::make_pair(keys[network->source_indexes[s]], s));
         }
         std::cout << "begin hilbert" << std::endl;
-        std::sort(customers.begin(), customers.end(), hilbert_comparator);
+        radix_sort(customers);
         for (long i = 0; i < sources.size(); i++) {
-            sources[i] = customers[i].index;
+            sources[i] = customers[i].second;
         }
         this->hilbert_order = sources;
         this->hilbert_is_ready = true;
@@ -566,7 +997,7 @@ public:
                         logger->add(std::string("furthest traversal ") + std::to_string(source_id), -1);
                         return false;
                     }
-                    edges[source_id].push_front(std::make_pair(new_edge.target_node, new_edge.weight));
+                    edges.addArc(source_id, new_edge.target_node, new_edge.weight);
                     backwards_edges[source_id].push_back(std::make_pair(new_edge.target_node, new_edge.weight));
                     it = std::prev(backwards_edges[source_id].end());
                 } else {
@@ -575,7 +1006,7 @@ public:
             }
             weight = -it->second;
             target_node = it->first;
-            edges[target_node].push_front(std::make_pair(source_id,weight));
+            edges.addArc(target_node, source_id, weight);
             node_excess[source_id]++;
             node_excess[target_node]--;
 
@@ -587,6 +1018,19 @@ public:
 
 
 
+    /*
+     * Increase the demand of a particular customer without matching it, for matchBatched
+     * Returns false if the customer already has demand equal to every possible facility
+     */
+    bool increaseDemand(I vid) {
+        F pending = std::max((F) 0, -this->node_excess[vid]);
+        if (total_matched[vid] + pending >= this->edge_generator->m) {
+            return false;
+        }
+        this->node_excess[vid] -= 1;
+        return true;
+    }
+
     /*
      * Increase the demand of a particular customer
      */
@@ -624,6 +1068,210 @@ public:
         return result;
     }
 
+    /*
+     * Dynamic updates: sources are removed or relocated and targets change capacities after the matching is built.
+     *
+     * SIA keeps reduced costs of all residual arcs non-negative and potentials of non-full targets zero
+     * (they are raised only while they are full), which certifies that the matching is optimal for the matched
+     * demands. A returned unit restores an arc from its source, which is not tight if the source was an origin
+     * of a later search, so its reduced cost may be negative. Thus a source that gets a unit back returns all
+     * its units and its potential becomes zero: no arcs come into it and arcs out of it are not negative.
+     * Targets that become non-full break the second condition, repairPotentials restores it. Then the unmatched
+     * demand is matched by the usual SIA from valid potentials, so the cost is in the changed part of the matching.
+     *
+     * Matched arcs are stored at targets, so the generated edges are indexed both ways at the first update
+     * (see buildEdgeIndex) and an update only visits the arcs of the sources and targets it touches.
+     */
+
+    /*
+     * Index the edges of the bipartite graph by source and by target, new edges are added by addNewEdge
+     */
+    void buildEdgeIndex() {
+        if (edge_index_ready) {
+            return;
+        }
+        source_targets.assign(source_count, std::vector<I>());
+        target_sources.assign(graph_size, std::vector<Edge>());
+        for (I source = 0; source < source_count; source++) {
+            for (auto& arc : edges[source]) {
+                indexEdge(source, arc.first, arc.second);
+            }
+        }
+        for (I target = source_count; target < graph_size; target++) {
+            for (auto& arc : edges[target]) {
+                indexEdge(arc.first, target, -arc.second);
+            }
+        }
+        edge_index_ready = true;
+    }
+
+    inline void indexEdge(I source, I target, W weight) {
+        source_targets[source].push_back(target);
+        target_sources[target].push_back(Edge(source, weight));
+    }
+
+    /*
+     * Forget all edges of a source, e.g. when it is relocated
+     */
+    void unindexSource(I source) {
+        for (auto target : source_targets[source]) {
+            std::vector<Edge>& sources = target_sources[target];
+            for (I position = 0; position < sources.size(); position++) {
+                if (sources[position].first == source) {
+                    sources[position] = sources.back();
+                    sources.pop_back();
+                    break;
+                }
+            }
+        }
+        source_targets[source].clear();
+    }
+
+    /*
+     * Return all matched units of the sources, targets that become non-full are appended to <freed>
+     * Only the targets of the edges of the sources are visited
+     */
+    void unmatchSources(std::vector<I>& sources, std::vector<I>& freed) {
+        for (auto source : sources) {
+            for (auto target : source_targets[source]) {
+                Adjlist& arcs = edges[target];
+                I position = 0;
+                while (position < arcs.size()) {
+                    if (arcs[position].first != source) {
+                        position++;
+                        continue;
+                    }
+                    edges.flipArc(target, position); //the last arc takes the position
+                    if (node_excess[target] == 0) {
+                        freed.push_back(target);
+                    }
+                    node_excess[target] += 1;
+                    node_excess[source] -= 1;
+                    total_matched[source] -= 1;
+                }
+            }
+        }
+    }
+
+    /*
+     * Set potentials of freed targets to zero. Arcs from sources into them may get a negative reduced cost:
+     * such a source prefers the freed target to its matching, so all its units are returned and its potential
+     * is zero too, which may free more targets. Sources that returned units are appended to <pending>.
+     * Each round visits the edges into the targets freed in the previous one, sources are marked by phase_id
+     */
+    void repairPotentials(std::vector<I>& freed, std::vector<I>& pending) {
+        std::vector<I> violated;
+        while (!freed.empty()) {
+            phase_id++;
+            violated.clear();
+            for (auto target : freed) {
+                if (potentials[target] == 0) {
+                    continue;
+                }
+                potentials[target] = 0;
+                for (auto& edge : target_sources[target]) {
+                    I source = edge.first;
+                    //matched edges are arcs of the target and get a larger reduced cost
+                    if (phase_visited[source] != phase_id && edgeCost(edge.second, source, target) < 0 &&
+                        edges.findArc(source, target) != -1) {
+                        phase_visited[source] = phase_id;
+                        violated.push_back(source);
+                    }
+                }
+            }
+            freed.clear();
+            unmatchSources(violated, freed);
+            for (auto source : violated) {
+                potentials[source] = 0; //no arcs come into the source, and arcs out of it are not shorter than zero
+                pending.push_back(source);
+            }
+        }
+    }
+
+    /*
+     * Match the negative excess of the sources, e.g. after a dynamic update
+     */
+    void matchPending(std::vector<I>& sources) {
+        for (auto source : sources) {
+            while (node_excess[source] < 0) {
+                try {
+                    matchVertex(source);
+                } catch (NoMoreEdgesToAdd& e) {
+                    node_excess[source] = 0; //no more facilities for the source, as in increaseCapacity
+                }
+            }
+        }
+    }
+
+    /*
+     * Remove the demand of a source, its units are matched to other sources if it is better
+     */
+    void removeSource(I source) {
+        buildEdgeIndex();
+        std::vector<I> sources(1, source);
+        std::vector<I> freed;
+        unmatchSources(sources, freed);
+        node_excess[source] = 0;
+        potentials[source] = 0;
+        repairPotentials(freed, sources);
+        matchPending(sources);
+    }
+
+    /*
+     * Move a source to another node of the network with a new demand, edges are generated from the new place
+     */
+    void relocateSource(I source, long node, F demand = 1) {
+        buildEdgeIndex();
+        std::vector<I> sources(1, source);
+        std::vector<I> freed;
+        unmatchSources(sources, freed);
+        unindexSource(source);
+        edges.clear(source); //arcs with distances from the old place
+        potentials[source] = 0;
+        edge_generator->relocateSource(source, node);
+        newEdge e = edge_generator->getEdge(source);
+        extra_edge_added_per_source[source] = !e.exists;
+        new_edges[source] = e.exists ? e : getEdgeToExtraNode(source);
+        node_excess[source] = -demand;
+        repairPotentials(freed, sources);
+        matchPending(sources);
+    }
+
+    /*
+     * Change the capacity of a target by <delta>, units over a smaller capacity are matched elsewhere
+     */
+    void changeTargetCapacity(I target, F delta) {
+        Adjlist& arcs = edges[target];
+        if (node_excess[target] + (F) arcs.size() + delta < 0) {
+            throw std::logic_error("Capacity of a target cannot be negative");
+        }
+        buildEdgeIndex();
+        std::vector<I> sources;
+        std::vector<I> freed;
+        if (delta > 0 && node_excess[target] == 0) {
+            freed.push_back(target);
+        }
+        if (node_excess[target] + delta < 0) {
+            //sources of the units over the new capacity return all their units, as in removeSource
+            phase_id++;
+            I position = arcs.size();
+            for (F over = -(node_excess[target] + delta); over > 0; over--) {
+                I source = arcs[--position].first;
+                if (phase_visited[source] != phase_id) {
+                    phase_visited[source] = phase_id;
+                    sources.push_back(source);
+                }
+            }
+            unmatchSources(sources, freed);
+            for (auto source : sources) {
+                potentials[source] = 0;
+            }
+        }
+        node_excess[target] += delta;
+        repairPotentials(freed, sources);
+        matchPending(sources);
+    }
+
     inline bool ifAllSourceMatchedExactlyOnce() {
         std::vector<bool> is_matched(this->edge_generator->n, false);
         for (long i = this->edge_generator->n; i < this->edge_generator->n + this->edge_generator->m; i++) {
@@ -656,6 +1304,48 @@ public:
                 result_weight += abs(it->second);
             }
         }
+
+        if (this->epsilon > 0) {
+            this->logger->add("certified gap", certifiedGap());
+            this->logger->add("added edges", added_edges);
+        }
+    }
+
+    /*
+     * Relative gap between the cost of the current matching (with the extra node) and a lower bound of the optimum
+     *
+     * The bound is the dual objective of the assignment LP given by the potentials: customers get their potential,
+     * but not more than the weight of their next edge to be generated (all later edges are not shorter), facilities
+     * pay their potential per unit of capacity, and every generated edge that violates the dual constraint pays
+     * the violation. It is a valid bound for any potentials, and for the exact matching that does not use
+     * the extra node it equals the cost, so the gap is zero. Meaningful after all demands are matched
+     */
+    double certifiedGap()
+    {
+        double cost = 0;
+        double bound = 0;
+        std::vector<double> customer_dual(source_count);
+        for (I i = 0; i < source_count; i++) {
+            customer_dual[i] = potentials[i];
+            if (new_edges[i].exists) {
+                customer_dual[i] = std::min(customer_dual[i], (double) new_edges[i].weight);
+            }
+            bound += customer_dual[i] * (total_matched[i] - node_excess[i]);
+            for (EdgeIterator it = edges[i].begin(); it != edges[i].end(); it++) {
+                bound -= std::max(0.0, customer_dual[i] - potentials[it->first] - it->second);
+            }
+        }
+        for (I i = source_count; i < graph_size; i++) {
+            bound -= (double) potentials[i] * ((double) node_excess[i] + edges[i].size());
+            for (EdgeIterator it = edges[i].begin(); it != edges[i].end(); it++) {
+                cost -= it->second; //matched edges are inverted
+                bound -= std::max(0.0, customer_dual[it->first] - potentials[i] + it->second);
+            }
+        }
+        if (cost <= bound) {
+            return 0;
+        }
+        return bound > 0 ? (cost - bound) / bound : std::numeric_limits<double>::infinity();
     }
 
     bool ifTargetCapacitated(long target_id) {
@@ -668,9 +1358,7 @@ public:
     }
 
     inline long get_bi_outdegree(long bi_node_id) {
-        long i = 0;
-        for (auto &x : this->edges[bi_node_id]) i++;
-        return i;
+        return this->edges.outdegree(bi_node_id);
     }
 
     void print_edgelist() {
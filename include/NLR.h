@@ -25,7 +25,11 @@
 #include "helpers.h"
 #include "exceptions.h"
 
-class NLR {
+/*
+ * Template types stand for < weight/potentials/cost type, node/edge index type > of the matching, see NLR and NLR32
+ */
+template<typename W, typename I>
+class BasicNLR {
 public:
     struct {
         bool any_facility_nlr = true; // NLRs are calculated as the distance to any placed facility, ignoring capacitated ones
@@ -133,8 +137,8 @@ public:
             new_excess[i] = this->facility_capacities[facility_index];
         }
 
-        TargetExploringEdgeGenerator<long, long> bigraph_generator(*this->network, this->located_facility_target_indexes);
-        Matcher<long,long,long> M(&bigraph_generator, new_excess, this->logger);
+        TargetExploringEdgeGenerator<I,W> bigraph_generator(*this->network, this->located_facility_target_indexes);
+        Matcher<long,W,I> M(&bigraph_generator, new_excess, this->logger);
         M.network = this->network;
         M.match();
 
@@ -321,12 +325,12 @@ public:
         get_facilities_available_per_component(customers_per_component, capacities_per_component, min_capacity_per_component);
     }
 
-    NLR(Network& network, Logger* logger, long facility_capacity, long required_facilities) {
+    BasicNLR(Network& network, Logger* logger, long facility_capacity, long required_facilities) {
         //setting variables once per multiple algorithm runs
         this->logger = logger;
         this->network = &network;
         this->required_facilities = required_facilities;
-        this->edge_generator = new TargetExploringEdgeGenerator<long, long>(network, network.target_indexes);
+        this->edge_generator = new TargetExploringEdgeGenerator<I,W>(network, network.target_indexes);
         this->facility_indexes = network.target_indexes;
         buildInverseFacilityIndex();
         this->facility_capacities = network.target_capacities;
@@ -340,7 +344,7 @@ public:
         calculateMaxFacilitiesPerComponent();
     }
 
-    ~NLR() {}
+    ~BasicNLR() {}
 
     void run() {
         reset();
@@ -360,4 +364,7 @@ public:
     }
 };
 
+typedef BasicNLR<long,long> NLR;
+typedef BasicNLR<int32_t,int32_t> NLR32; //half of the memory of matching, see Network::fits_types
+
 #endif //FCLA_NLR_H
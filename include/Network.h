@@ -12,7 +12,14 @@
 #include <iostream>
 #include <fstream>
 #include <time.h>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
 #include "exceptions.h"
+#include "HilbertKeys.h"
+
+#define EXTRA_NODE_WEIGHT 1000000 //weight of an assignment to the extra node in Matcher
+#define REDUCED_COST_TERMS 4 //distances and potentials summed in one reduced cost: mindist + weight - potential + potential
 
 class Network {
 public:
@@ -23,6 +30,7 @@ public:
     std::vector<long> target_indexes;
     std::vector<long> target_capacities;
     std::vector<std::pair<double,double>> coords; //in case there are coordinates
+    std::vector<uint64_t> hilbert_keys; //Hilbert indexes of nodes by coordinates, see get_hilbert_keys
 
     static std::string generate_id() {
         struct timespec spec;
@@ -38,7 +46,7 @@ public:
     Network(igraph_t* g,
             std::vector<long>& weights,
             std::vector<long>& source_indexes,
-            std::vector<Coords>& coords) {
+            std::vector<std::pair<double,double>>& coords) {
         igraph_copy(&this->graph, g);
         this->weights = weights;
         this->source_indexes = source_indexes;
@@ -67,6 +75,16 @@ public:
         igraph_destroy(&this->graph);
     }
 
+    /*
+     * Hilbert index of every node by its coordinates, computed once and shared by all solvers
+     */
+    const std::vector<uint64_t>& get_hilbert_keys() {
+        if (hilbert_keys.size() != coords.size()) {
+            hilbert_keys = compute_hilbert_keys(coords);
+        }
+        return hilbert_keys;
+    }
+
     long graph_size() {
         igraph_integer_t vcount = igraph_vcount(&this->graph);
         return static_cast<long>(vcount);
@@ -76,6 +94,44 @@ public:
         return source_indexes.size();
     }
 
+    /*
+     * Upper bound of the length of a shortest path: not longer than all edges together and than V-1 longest edges
+     */
+    long path_length_bound() {
+        const long max_long = std::numeric_limits<long>::max();
+        long total = 0;
+        long longest = 0;
+        for (auto weight : weights) {
+            if (weight < 0) {
+                throw std::invalid_argument("Weights of the network must not be negative");
+            }
+            total = (total > max_long - weight) ? max_long : total + weight;
+            longest = std::max(longest, weight);
+        }
+        long edges_on_path = std::max(this->graph_size() - 1, 0L);
+        if (longest > 0 && edges_on_path > max_long / longest) {
+            return total;
+        }
+        return std::min(total, edges_on_path * longest);
+    }
+
+    /*
+     * Check if matching on this network fits into index type I and weight type W
+     *
+     * Ids of the bipartite graph go up to customers + nodes + the extra node. A potential of a customer is never
+     * larger than the weight of its next edge (or the extra node edge), potentials of facilities are not larger than
+     * of their customers, so distances and potentials are bounded by a path length plus the extra node weight
+     */
+    template<typename I, typename W>
+    bool fits_types(long extra_weight = EXTRA_NODE_WEIGHT) {
+        long bipartite_size = this->number_of_customers() + this->graph_size() + 1;
+        if (bipartite_size > (long) std::numeric_limits<I>::max()) {
+            return false;
+        }
+        long max_weight = (long) std::numeric_limits<W>::max() / REDUCED_COST_TERMS;
+        return extra_weight <= max_weight && this->path_length_bound() <= max_weight - extra_weight;
+    }
+
     void save(std::string dir, std::string filename) {
         std::ofstream outf(filename,std::ios::out);
         outf << this->id << " "
@@ -121,6 +177,9 @@ public:
             weights.push_back(weight);
         }
         igraph_add_edges(&this->graph, &edges, 0);
+        if (!this->fits_types<long,long>()) {
+            throw std::overflow_error("Weights of the network are too large for the matching");
+        }
 
         igraph_bool_t check_multiple;
         igraph_has_multiple(&this->graph, &check_multiple);
@@ -0,0 +1,273 @@
+/*
+ * Indexed pairing heap with the interface of fHeap (see nheap.h).
+ *
+ * Nodes are stored by idx in one array, children of a node form a doubly linked list (prev of the first child
+ * is the parent). Enqueue and decrease-key are O(1), dequeue is amortized O(log n) with the two-pass merge.
+ * An increase of a key removes the node and inserts it again.
+ */
+
+#ifndef FCLA_PAIRINGHEAP_H
+#define FCLA_PAIRINGHEAP_H
+
+#include <vector>
+#include <functional>
+#include <utility>
+
+template <class V, class I, class Compare = std::less<V>>
+class PairingHeap {
+public:
+    PairingHeap() {
+        root = -1;
+        count = 0;
+    }
+    ~PairingHeap() {}
+
+    void clear() {
+        nodes.clear();
+        members.clear();
+        root = -1;
+        count = 0;
+    }
+
+    void reset() {
+        clear();
+    }
+
+    /*
+     * Empty the heap keeping the allocated nodes, the cost is proportional to the number of elements
+     * enqueued since the last clear
+     */
+    void softClear() {
+        for (auto idx : members) {
+            nodes[idx].in_heap = false;
+            nodes[idx].listed = false;
+        }
+        members.clear();
+        root = -1;
+        count = 0;
+    }
+
+    inline I size() const {
+        return count;
+    }
+
+    inline bool isExisted(I idx) const {
+        return idx < nodes.size() && nodes[idx].in_heap;
+    }
+
+    bool isExisted(I idx, V& value) const {
+        if (!isExisted(idx)) {
+            return false;
+        }
+        value = nodes[idx].value;
+        return true;
+    }
+
+    inline V getVal(I idx) const {
+        return nodes[idx].value;
+    }
+
+    inline V getTopValue() const {
+        return nodes[root].value;
+    }
+
+    inline I getTopIdx() const {
+        return root;
+    }
+
+    void getTop(I& idx, V& value) const {
+        idx = root;
+        value = nodes[root].value;
+    }
+
+    void enqueue(I idx, V value) {
+        if (idx >= nodes.size()) {
+            nodes.resize(idx + 1, Node());
+        }
+        Node& node = nodes[idx];
+        node.value = value;
+        node.child = -1;
+        node.sibling = -1;
+        node.prev = -1;
+        node.in_heap = true;
+        if (!node.listed) {
+            node.listed = true;
+            members.push_back(idx);
+        }
+        root = link(root, idx);
+        count++;
+    }
+
+    /*
+     * Returns 0 if the heap is empty, as fHeap does
+     */
+    I dequeue(I& idx) {
+        if (count == 0) {
+            return 0;
+        }
+        idx = popTop();
+        return 1;
+    }
+
+    I dequeue() {
+        if (count == 0) {
+            return 0;
+        }
+        return popTop();
+    }
+
+    bool dequeue(I& idx, V& value) {
+        if (count == 0) {
+            return false;
+        }
+        value = nodes[root].value;
+        idx = popTop();
+        return true;
+    }
+
+    void updatequeue(I idx, V new_val) {
+        Node& node = nodes[idx];
+        if (compare(new_val, node.value)) {
+            node.value = new_val;
+            if (idx != root) {
+                cut(idx);
+                root = link(root, idx);
+            }
+        } else if (compare(node.value, new_val)) {
+            detach(idx);
+            nodes[idx].value = new_val;
+            root = link(root, idx);
+        }
+    }
+
+    bool updateorenqueue(I idx, V new_val) {
+        if (isExisted(idx)) {
+            updatequeue(idx, new_val);
+            return true;
+        }
+        enqueue(idx, new_val);
+        return false;
+    }
+
+    bool remove(I idx) {
+        if (!isExisted(idx)) {
+            return false;
+        }
+        detach(idx);
+        nodes[idx].in_heap = false;
+        count--;
+        return true;
+    }
+
+private:
+    struct Node {
+        V value;
+        I child = -1;
+        I sibling = -1;
+        I prev = -1; //left sibling or the parent for the first child
+        bool in_heap = false;
+        bool listed = false; //is in members
+    };
+
+    std::vector<Node> nodes;
+    std::vector<I> members; //indexes enqueued since the last clear
+    std::vector<I> merge_buffer;
+    I root;
+    I count;
+    Compare compare;
+
+    /*
+     * Link two roots, the one with the smaller value becomes the parent, on ties the first one
+     */
+    inline I link(I a, I b) {
+        if (a == -1) {
+            return b;
+        }
+        if (b == -1) {
+            return a;
+        }
+        if (compare(nodes[b].value, nodes[a].value)) {
+            std::swap(a, b);
+        }
+        Node& parent = nodes[a];
+        Node& child = nodes[b];
+        child.sibling = parent.child;
+        if (parent.child != -1) {
+            nodes[parent.child].prev = b;
+        }
+        child.prev = a;
+        parent.child = b;
+        return a;
+    }
+
+    /*
+     * Detach a subtree from its parent or left sibling, the node must not be the root
+     */
+    inline void cut(I idx) {
+        Node& node = nodes[idx];
+        if (nodes[node.prev].child == idx) {
+            nodes[node.prev].child = node.sibling;
+        } else {
+            nodes[node.prev].sibling = node.sibling;
+        }
+        if (node.sibling != -1) {
+            nodes[node.sibling].prev = node.prev;
+        }
+        node.sibling = -1;
+        node.prev = -1;
+    }
+
+    /*
+     * Take a node out of the heap, its children are merged back
+     */
+    void detach(I idx) {
+        I children = nodes[idx].child;
+        nodes[idx].child = -1;
+        if (idx == root) {
+            root = mergePairs(children);
+        } else {
+            cut(idx);
+            root = link(root, mergePairs(children));
+        }
+    }
+
+    I popTop() {
+        I top = root;
+        root = mergePairs(nodes[top].child);
+        nodes[top].child = -1;
+        nodes[top].in_heap = false;
+        count--;
+        return top;
+    }
+
+    /*
+     * Two-pass merge of a list of siblings: link pairs from left to right, then the results from right to left
+     */
+    I mergePairs(I first) {
+        if (first == -1) {
+            return -1;
+        }
+        merge_buffer.clear();
+        while (first != -1) {
+            I next = nodes[first].sibling;
+            nodes[first].sibling = -1;
+            nodes[first].prev = -1;
+            merge_buffer.push_back(first);
+            first = next;
+        }
+        I paired = 0;
+        for (I i = 0; i + 1 < merge_buffer.size(); i += 2) {
+            merge_buffer[paired++] = link(merge_buffer[i], merge_buffer[i + 1]);
+        }
+        if (merge_buffer.size() % 2 == 1) {
+            merge_buffer[paired++] = merge_buffer.back();
+        }
+        I result = merge_buffer[paired - 1];
+        for (I i = paired - 2; i >= 0; i--) {
+            result = link(merge_buffer[i], result);
+        }
+        return result;
+    }
+};
+
+#endif //FCLA_PAIRINGHEAP_H
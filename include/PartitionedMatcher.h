@@ -0,0 +1,377 @@
+/*
+ * Matching in spatial partitions: customers and facilities are split into parts (e.g. by Hilbert order of their
+ * coordinates), every part is matched by its own Matcher on a separate thread, and the result is repaired
+ * by one global SIA pass.
+ *
+ * The repair pass starts from the partition matchings and potentials. Potentials of a part are valid
+ * for the edges inside of the part, but an edge to a facility of another part may have a negative reduced cost.
+ * Such edges are found among the edges of a customer that are shorter than its potential (edges that are not
+ * generated are longer). Customers with a violated edge are unmatched and get the largest potential that is valid
+ * for all their edges, facilities with free capacity get potential 0. This is repeated until all reduced costs are
+ * non-negative, then the unmatched demand is matched by the usual SIA with the repaired potentials.
+ *
+ * Edges are generated once: all edges taken by partitions are recorded per customer and replayed in the global pass.
+ * The wrapped edge generator is not thread safe, so calls to it are serialized.
+ */
+
+#ifndef FCLA_PARTITIONEDMATCHER_H
+#define FCLA_PARTITIONEDMATCHER_H
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+#include "Matcher.h"
+#include "EdgeGenerator.h"
+#include "Logger.h"
+#include "HilbertKeys.h"
+#include "helpers.h"
+#include "exceptions.h"
+
+/*
+ * Remembers all edges of every source taken from another generator, and replays them after reset
+ */
+class RecordingEdgeGenerator : public EdgeGenerator {
+public:
+    EdgeGenerator* base;
+    std::vector<newEdges> recorded;
+    std::vector<long> cursor;
+
+    RecordingEdgeGenerator(EdgeGenerator* base) {
+        this->base = base;
+        this->n = base->n;
+        this->m = base->m;
+        recorded.resize(this->n);
+        reset();
+    }
+    ~RecordingEdgeGenerator() {}
+
+    /*
+     * Edge number <position> of a source, generated if needed. Thread safe for different sources
+     */
+    newEdge getRecorded(long vid, long position) {
+        if (position < recorded[vid].size()) {
+            return recorded[vid][position];
+        }
+        newEdge e;
+        #pragma omp critical(recording_edge_generator)
+        {
+            e = base->getEdge(vid);
+        }
+        if (e.exists) {
+            recorded[vid].push_back(e);
+        }
+        return e;
+    }
+
+    bool isComplete(long vid) override {
+        return cursor[vid] == recorded[vid].size() && base->isComplete(vid);
+    }
+
+    newEdge getEdge(long vid) override {
+        newEdge e = getRecorded(vid, cursor[vid]);
+        if (e.exists) {
+            cursor[vid]++;
+        }
+        return e;
+    }
+
+    void reset() override {
+        cursor.assign(this->n, 0);
+    }
+};
+
+/*
+ * Edges of the customers of one part to the facilities of the same part, in local ids of the part
+ */
+class PartitionEdgeGenerator : public EdgeGenerator {
+public:
+    RecordingEdgeGenerator* recorder;
+    std::vector<long> sources; //global ids of the customers of the part
+    std::vector<long>* part_of; //part of every customer and facility in the global bipartite graph
+    std::vector<long>* local_index; //index of a customer or a facility inside of its part
+    long part;
+    std::vector<long> cursor;
+
+    PartitionEdgeGenerator(RecordingEdgeGenerator* recorder, std::vector<long>& sources, long facility_count,
+                           std::vector<long>* part_of, std::vector<long>* local_index, long part) {
+        this->recorder = recorder;
+        this->sources = sources;
+        this->part_of = part_of;
+        this->local_index = local_index;
+        this->part = part;
+        this->n = sources.size();
+        this->m = facility_count;
+        reset();
+    }
+    ~PartitionEdgeGenerator() {}
+
+    newEdge getEdge(long vid) override {
+        while (true) {
+            newEdge e = recorder->getRecorded(sources[vid], cursor[vid]);
+            if (!e.exists) {
+                return e;
+            }
+            cursor[vid]++;
+            if ((*part_of)[e.target_node] == part) {
+                e.source_node = vid;
+                e.target_node = this->n + (*local_index)[e.target_node];
+                return e;
+            }
+        }
+    }
+
+    void reset() override {
+        cursor.assign(this->n, 0);
+    }
+};
+
+template<typename F, typename W, typename I>
+class PartitionedMatcher : public Matcher<F,W,I> {
+public:
+    std::vector<long> part_of;
+    long part_count;
+    long repaired_sources; //customers unmatched in the repair pass
+
+    /*
+     * part_of gives a part for every customer and facility of the bipartite graph (without the extra node)
+     */
+    PartitionedMatcher(EdgeGenerator* edge_generator, std::vector<F>& node_excess, std::vector<long>& part_of,
+                       long part_count, Logger* logger, bool allow_extra_node_assignment=true) {
+        this->recorder = new RecordingEdgeGenerator(edge_generator);
+        this->edge_generator = this->recorder;
+        this->graph_size = edge_generator->n + edge_generator->m + 1;
+        this->source_count = edge_generator->n;
+        this->node_excess = node_excess;
+        this->node_excess.push_back(std::numeric_limits<long>::max()); //extra node, as in Matcher
+        this->allow_extra_node_assignment = allow_extra_node_assignment;
+        this->logger = logger;
+        this->part_of = part_of;
+        this->part_count = part_count;
+        this->repaired_sources = 0;
+        this->reset();
+    }
+
+    ~PartitionedMatcher() {
+        delete this->recorder;
+    }
+
+    /*
+     * Split customers and facilities into parts of consecutive nodes in the Hilbert order.
+     * A part is closed when it has its share of the demand and enough capacity for it,
+     * the last part is merged into the previous ones until it has enough capacity too
+     *
+     * coords and node_excess are given for all customers and facilities of the bipartite graph
+     */
+    static std::vector<long> hilbertPartition(std::vector<Coords>& coords, std::vector<F>& node_excess, long part_count) {
+        std::vector<uint64_t> keys = compute_hilbert_keys(coords);
+        std::vector<std::pair<uint64_t, long>> ordered(coords.size());
+        F total_demand = 0;
+        for (long i = 0; i < ordered.size(); i++) {
+            ordered[i] = std::make_pair(keys[i], i);
+            total_demand -= std::min((F) 0, node_excess[i]);
+        }
+        radix_sort(ordered);
+        std::vector<long> order(coords.size());
+        for (long i = 0; i < order.size(); i++) {
+            order[i] = ordered[i].second;
+        }
+        F share = (total_demand + part_count - 1) / part_count;
+        std::vector<long> part_of(coords.size());
+        std::vector<F> demand(part_count, 0);
+        std::vector<F> capacity(part_count, 0);
+        long part = 0;
+        for (auto node : order) {
+            part_of[node] = part;
+            if (node_excess[node] < 0) {
+                demand[part] -= node_excess[node];
+            } else {
+                capacity[part] += node_excess[node];
+            }
+            if (demand[part] >= share && capacity[part] >= demand[part] && part < part_count - 1) {
+                part++;
+            }
+        }
+        long last = part;
+        while (last > 0 && capacity[last] < demand[last]) {
+            demand[last - 1] += demand[last];
+            capacity[last - 1] += capacity[last];
+            last--;
+        }
+        for (auto& node_part : part_of) {
+            node_part = std::min(node_part, last);
+        }
+        return part_of;
+    }
+
+    void match() {
+        this->logger->start("partitioned matching");
+        matchParts();
+        repairPotentials();
+        this->logger->add("repaired sources", repaired_sources);
+        //round-robin of Matcher::match never stops if there is nothing to match
+        bool has_demand = false;
+        for (I source = 0; source < this->source_count; source++) {
+            has_demand |= this->node_excess[source] < 0;
+        }
+        if (has_demand) {
+            Matcher<F,W,I>::match();
+        }
+        this->logger->finish("partitioned matching");
+    }
+
+private:
+    RecordingEdgeGenerator* recorder;
+    std::vector<std::vector<I>> matched_facilities; //facilities matched with a customer in its part
+
+    /*
+     * Run Matcher in every part and take over matched edges and potentials
+     */
+    void matchParts() {
+        std::vector<std::vector<long>> part_sources(part_count);
+        std::vector<std::vector<long>> part_facilities(part_count);
+        std::vector<long> local_index(this->graph_size - 1);
+        for (long i = 0; i < local_index.size(); i++) {
+            std::vector<long>& members = i < this->source_count ? part_sources[part_of[i]] : part_facilities[part_of[i]];
+            local_index[i] = members.size();
+            members.push_back(i);
+        }
+
+        std::vector<std::unique_ptr<PartitionEdgeGenerator>> generators(part_count);
+        std::vector<std::unique_ptr<Matcher<F,W,I>>> matchers(part_count);
+        std::vector<Logger> loggers(part_count); //Logger is not thread safe
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (long part = 0; part < part_count; part++) {
+            std::vector<long>& sources = part_sources[part];
+            std::vector<long>& facilities = part_facilities[part];
+            std::vector<F> excess;
+            bool has_demand = false;
+            for (auto node : sources) {
+                excess.push_back(this->node_excess[node]);
+                has_demand |= this->node_excess[node] < 0;
+            }
+            if (!has_demand) {
+                continue; //Matcher::match needs something to match
+            }
+            for (auto node : facilities) {
+                excess.push_back(this->node_excess[node]);
+            }
+            generators[part].reset(new PartitionEdgeGenerator(recorder, sources, facilities.size(), &part_of, &local_index, part));
+            matchers[part].reset(new Matcher<F,W,I>(generators[part].get(), excess, &loggers[part]));
+            try {
+                matchers[part]->match();
+            } catch (NoMoreEdgesToAdd& e) {
+                matchers[part].reset();
+                continue;
+            }
+            //the extra node inflates potentials of the whole part, and then all customers of the part
+            //would take edges up to the weight of the extra node. Such parts are matched by the repair pass only
+            if (matchers[part]->edges.outdegree(matchers[part]->getExtraNodeIndex()) > 0) {
+                matchers[part].reset();
+            }
+        }
+
+        //customers are seeded one by one, because the residual graph of a facility is shared between customers
+        matched_facilities.assign(this->source_count, std::vector<I>());
+        for (long part = 0; part < part_count; part++) {
+            if (!matchers[part]) {
+                continue;
+            }
+            Matcher<F,W,I>& local = *matchers[part];
+            long local_sources = part_sources[part].size();
+            for (long f = 0; f < part_facilities[part].size(); f++) {
+                I facility = part_facilities[part][f];
+                this->potentials[facility] = local.potentials[local_sources + f];
+                for (auto& arc : local.edges[local_sources + f]) {
+                    matched_facilities[part_sources[part][arc.first]].push_back(facility);
+                }
+            }
+            for (long c = 0; c < local_sources; c++) {
+                I source = part_sources[part][c];
+                this->potentials[source] = local.potentials[c];
+                seedSource(source);
+            }
+        }
+    }
+
+    /*
+     * Add edges of a source to the residual graph in the generator order: all matched ones and all shorter
+     * than the potential of the source, so that the reduced cost of edges that are not added is non-negative
+     */
+    void seedSource(I source) {
+        std::vector<I>& facilities = matched_facilities[source];
+        long remaining = facilities.size();
+        while (this->new_edges[source].exists && (remaining > 0 || this->new_edges[source].weight < this->potentials[source])) {
+            newEdge e = this->new_edges[source];
+            if (std::find(facilities.begin(), facilities.end(), (I) e.target_node) != facilities.end()) {
+                this->edges.addArc(e.target_node, source, -e.weight);
+                this->node_excess[source] += 1;
+                this->node_excess[e.target_node] -= 1;
+                this->total_matched[source] += 1;
+                remaining--;
+            } else {
+                this->edges.addArc(source, e.target_node, e.weight);
+            }
+            newEdge next_edge = this->edge_generator->getEdge(source);
+            if (!next_edge.exists && !this->extra_edge_added_per_source[source]) {
+                this->extra_edge_added_per_source[source] = true;
+                next_edge = this->getEdgeToExtraNode(source);
+            }
+            this->new_edges[source] = next_edge;
+        }
+    }
+
+    /*
+     * Unmatch customers with negative reduced cost edges until all reduced costs are non-negative
+     * and facilities with free capacity have potential 0
+     */
+    void repairPotentials() {
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (I facility = this->source_count; facility < this->graph_size; facility++) {
+                if (this->node_excess[facility] > 0) {
+                    this->potentials[facility] = 0;
+                }
+            }
+            for (I source = 0; source < this->source_count; source++) {
+                bool violated = false;
+                for (auto& arc : this->edges[source]) {
+                    violated |= this->edgeCost(arc.second, source, arc.first) < 0;
+                }
+                if (!violated) {
+                    continue;
+                }
+                unmatchSource(source);
+                changed = true;
+            }
+        }
+    }
+
+    /*
+     * Give the demand of a customer back and set the largest potential valid for all its edges
+     */
+    void unmatchSource(I source) {
+        for (auto facility : matched_facilities[source]) {
+            I position = this->edges.findArc(facility, source);
+            if (position == -1) {
+                continue;
+            }
+            this->edges.flipArc(facility, position);
+            this->node_excess[source] -= 1;
+            this->node_excess[facility] += 1;
+            this->total_matched[source] -= 1;
+        }
+        if (!matched_facilities[source].empty()) {
+            repaired_sources++;
+            matched_facilities[source].clear();
+        }
+        W potential = this->new_edges[source].exists ? this->new_edges[source].weight : this->INF_W;
+        for (auto& arc : this->edges[source]) {
+            potential = std::min(potential, arc.second + this->potentials[arc.first]);
+        }
+        this->potentials[source] = potential == this->INF_W ? 0 : potential;
+    }
+};
+
+#endif //FCLA_PARTITIONEDMATCHER_H
@@ -0,0 +1,231 @@
+/*
+ * Indexed radix heap for integer keys with the interface of fHeap (see nheap.h).
+ *
+ * Only monotone sequences are supported: a key that is enqueued must not be smaller than the last dequeued key,
+ * as in Dijkstra with non-negative edge weights. Bucket b > 0 holds keys whose highest bit that differs
+ * from the last dequeued key is b-1, bucket 0 holds keys equal to it. Every key moves to a lower bucket
+ * at most once per bit, so dequeue is amortized O(log C) without any comparisons between keys.
+ * Keys are shifted to unsigned so that negative keys keep their order. Equal keys are dequeued in LIFO order.
+ */
+
+#ifndef FCLA_RADIXHEAP_H
+#define FCLA_RADIXHEAP_H
+
+#include <vector>
+#include <limits>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+
+template <class V, class I, class Compare = std::less<V>>
+class RadixHeap {
+    static_assert(std::is_integral<V>::value, "Radix heap supports only integer keys");
+    static_assert(std::is_same<Compare, std::less<V>>::value, "Radix heap is a min-heap only");
+public:
+    RadixHeap() {
+        buckets.resize(BUCKETS);
+        last = 0;
+        count = 0;
+    }
+    ~RadixHeap() {}
+
+    void clear() {
+        softClear();
+        bucket_of.clear();
+        position_of.clear();
+    }
+
+    void reset() {
+        clear();
+    }
+
+    /*
+     * Empty the heap keeping the allocated index, the minimal key is forgotten
+     */
+    void softClear() {
+        for (auto& bucket : buckets) {
+            for (auto& e : bucket) {
+                bucket_of[e.idx] = -1;
+            }
+            bucket.clear();
+        }
+        last = 0;
+        count = 0;
+    }
+
+    inline I size() const {
+        return count;
+    }
+
+    inline bool isExisted(I idx) const {
+        return idx < bucket_of.size() && bucket_of[idx] != -1;
+    }
+
+    bool isExisted(I idx, V& value) const {
+        if (!isExisted(idx)) {
+            return false;
+        }
+        value = getVal(idx);
+        return true;
+    }
+
+    inline V getVal(I idx) const {
+        return fromKey(buckets[bucket_of[idx]][position_of[idx]].key);
+    }
+
+    V getTopValue() {
+        normalize();
+        return fromKey(buckets[0].back().key);
+    }
+
+    I getTopIdx() {
+        normalize();
+        return buckets[0].back().idx;
+    }
+
+    void getTop(I& idx, V& value) {
+        normalize();
+        idx = buckets[0].back().idx;
+        value = fromKey(buckets[0].back().key);
+    }
+
+    void enqueue(I idx, V value) {
+        U key = toKey(value);
+        if (key < last) {
+            throw std::logic_error("Radix heap requires keys not smaller than the last dequeued key");
+        }
+        if (idx >= bucket_of.size()) {
+            bucket_of.resize(idx + 1, -1);
+            position_of.resize(idx + 1, -1);
+        }
+        insert(elem{key, idx});
+        count++;
+    }
+
+    /*
+     * Returns 0 if the heap is empty, as fHeap does
+     */
+    I dequeue(I& idx) {
+        V value;
+        return dequeue(idx, value) ? 1 : 0;
+    }
+
+    I dequeue() {
+        I idx = 0;
+        dequeue(idx);
+        return idx;
+    }
+
+    bool dequeue(I& idx, V& value) {
+        if (count == 0) {
+            return false;
+        }
+        normalize();
+        elem e = buckets[0].back();
+        buckets[0].pop_back();
+        bucket_of[e.idx] = -1;
+        count--;
+        idx = e.idx;
+        value = fromKey(e.key);
+        return true;
+    }
+
+    void updatequeue(I idx, V new_val) {
+        erase(idx);
+        count--;
+        enqueue(idx, new_val);
+    }
+
+    bool updateorenqueue(I idx, V new_val) {
+        if (isExisted(idx)) {
+            updatequeue(idx, new_val);
+            return true;
+        }
+        enqueue(idx, new_val);
+        return false;
+    }
+
+    bool remove(I idx) {
+        if (!isExisted(idx)) {
+            return false;
+        }
+        erase(idx);
+        count--;
+        return true;
+    }
+
+private:
+    typedef typename std::make_unsigned<V>::type U;
+    static const int BITS = std::numeric_limits<U>::digits;
+    static const int BUCKETS = BITS + 1;
+    struct elem {
+        U key;
+        I idx;
+    };
+
+    std::vector<std::vector<elem>> buckets;
+    std::vector<I> bucket_of; //-1 if not in the heap
+    std::vector<I> position_of;
+    U last; //the last dequeued key, all keys in the heap are not smaller
+    I count;
+
+    static inline U toKey(V value) {
+        return std::is_signed<V>::value ? (U) value ^ ((U) 1 << (BITS - 1)) : (U) value;
+    }
+
+    static inline V fromKey(U key) {
+        return std::is_signed<V>::value ? (V) (key ^ ((U) 1 << (BITS - 1))) : (V) key;
+    }
+
+    inline int bucketIndex(U key) const {
+        return key == last ? 0 : BITS - __builtin_clzll((unsigned long long) (key ^ last))
+                                  - (std::numeric_limits<unsigned long long>::digits - BITS);
+    }
+
+    inline void insert(const elem& e) {
+        int b = bucketIndex(e.key);
+        bucket_of[e.idx] = b;
+        position_of[e.idx] = buckets[b].size();
+        buckets[b].push_back(e);
+    }
+
+    inline void erase(I idx) {
+        std::vector<elem>& bucket = buckets[bucket_of[idx]];
+        I position = position_of[idx];
+        if (position != bucket.size() - 1) {
+            bucket[position] = bucket.back();
+            position_of[bucket[position].idx] = position;
+        }
+        bucket.pop_back();
+        bucket_of[idx] = -1;
+    }
+
+    /*
+     * Make the minimal key the last one and move the keys of its bucket to lower buckets
+     */
+    void normalize() {
+        if (!buckets[0].empty()) {
+            return;
+        }
+        int b = 1;
+        while (buckets[b].empty()) {
+            b++;
+        }
+        std::vector<elem> redistributed;
+        redistributed.swap(buckets[b]);
+        U min_key = redistributed[0].key;
+        for (auto& e : redistributed) {
+            if (e.key < min_key) {
+                min_key = e.key;
+            }
+        }
+        last = min_key;
+        for (auto& e : redistributed) {
+            insert(e);
+        }
+        redistributed.clear();
+        redistributed.swap(buckets[b]); //keep the memory of the bucket
+    }
+};
+
+#endif //FCLA_RADIXHEAP_H
@@ -0,0 +1,133 @@
+/*
+ * Residual bipartite graph of the matcher: outgoing arcs of each node are stored in one contiguous array per node.
+ *
+ * Arcs are removed by moving the last arc of the node into the freed position (swap-remove), so removing
+ * an arc with known position is O(1). Positions of arcs of a node stay valid as long as arcs are only appended.
+ * The matcher remembers the position of the arc used to reach every node in Dijkstra, so flipping
+ * an augmenting path costs O(1) per arc instead of a scan of a linked list.
+ *
+ * Optionally the graph logs nodes whose outgoing arcs have changed, so that users of the matching
+ * (see FacilityChooser::updateCoverageHeap) can follow it by deltas instead of rescanning all nodes.
+ */
+
+#ifndef FCLA_RESIDUALGRAPH_H
+#define FCLA_RESIDUALGRAPH_H
+
+#include <vector>
+#include <utility>
+
+template<typename I, typename W>
+class ResidualGraph {
+public:
+    typedef std::pair<I,W> Arc; //target node and weight
+    typedef std::vector<Arc> Arcs;
+    typedef typename Arcs::iterator ArcIterator;
+
+    std::vector<Arcs> arcs; //outgoing arcs per node, in order of insertion until the first removal
+    std::vector<I> changed_nodes; //nodes with changed arcs since the last takeChangedNodes, if tracking is on
+    std::vector<bool> node_changed;
+    bool track_changes = false;
+
+    ResidualGraph() {}
+    ~ResidualGraph() {}
+
+    void resize(I node_count) {
+        arcs.resize(node_count);
+        node_changed.resize(node_count, false);
+    }
+
+    /*
+     * Start or stop logging of changed nodes, the log is emptied
+     */
+    void trackChanges(bool enable) {
+        track_changes = enable;
+        changed_nodes.clear();
+        node_changed.assign(arcs.size(), false);
+    }
+
+    /*
+     * Move the log of changed nodes into <nodes> and start a new one
+     */
+    void takeChangedNodes(std::vector<I>& nodes) {
+        nodes.clear();
+        nodes.swap(changed_nodes);
+        for (auto node : nodes) {
+            node_changed[node] = false;
+        }
+    }
+
+    inline void markChanged(I node) {
+        if (track_changes && !node_changed[node]) {
+            node_changed[node] = true;
+            changed_nodes.push_back(node);
+        }
+    }
+
+    /*
+     * Remove all arcs, memory of per-node arrays is kept for reuse
+     */
+    void clear() {
+        for (I node = 0; node < arcs.size(); node++) {
+            arcs[node].clear();
+            markChanged(node);
+        }
+    }
+
+    void clear(I node) {
+        arcs[node].clear();
+        markChanged(node);
+    }
+
+    inline I size() const {
+        return arcs.size();
+    }
+
+    inline Arcs& operator[](I node) {
+        return arcs[node];
+    }
+
+    inline I outdegree(I node) const {
+        return arcs[node].size();
+    }
+
+    /*
+     * Returns position of the new arc in the array of the source node
+     */
+    inline I addArc(I source, I target, W weight) {
+        arcs[source].push_back(Arc(target, weight));
+        markChanged(source);
+        return arcs[source].size() - 1;
+    }
+
+    inline void removeArc(I source, I position) {
+        Arcs& node_arcs = arcs[source];
+        if (position != node_arcs.size() - 1) {
+            node_arcs[position] = node_arcs.back();
+        }
+        node_arcs.pop_back();
+        markChanged(source);
+    }
+
+    /*
+     * Replace an arc source->target by target->source with the opposite weight
+     */
+    inline void flipArc(I source, I position) {
+        Arc arc = arcs[source][position];
+        removeArc(source, position);
+        addArc(arc.first, source, -arc.second);
+    }
+
+    /*
+     * Linear search of an arc, -1 if there is no arc between the nodes
+     */
+    I findArc(I source, I target) const {
+        for (I i = 0; i < arcs[source].size(); i++) {
+            if (arcs[source][i].first == target) {
+                return i;
+            }
+        }
+        return -1;
+    }
+};
+
+#endif //FCLA_RESIDUALGRAPH_H
@@ -0,0 +1,123 @@
+/*
+ * Exploration of a network shared by several facility choosers on the same customers, e.g. a sweep over
+ * the number of facilities, capacities and lambda (see main.cpp).
+ *
+ * Edges of a customer are generated in increasing weight and do not depend on a chooser, so the nearest facilities
+ * found for a customer by one chooser are kept as a prefix and replayed to all others. Only the chooser that
+ * goes past the prefix of a customer explores the network further. Choosers may run on different threads:
+ * a prefix is guarded by a lock of its customer and calls to the wrapped generator are serialized.
+ */
+
+#ifndef FCLA_SHAREDEXPLORATION_H
+#define FCLA_SHAREDEXPLORATION_H
+
+#include <vector>
+#include <mutex>
+
+#include "EdgeGenerator.h"
+
+/*
+ * Prefixes of edges of every source taken from another generator, the generator is not owned
+ */
+class SharedExploration {
+public:
+    EdgeGenerator* base;
+    long n;
+    long m;
+
+    SharedExploration(EdgeGenerator* base) : recorded(base->n), locks(base->n) {
+        this->base = base;
+        this->n = base->n;
+        this->m = base->m;
+        base->reset();
+    }
+    ~SharedExploration() {}
+
+    /*
+     * Edge number <position> of a source, generated if needed
+     */
+    newEdge getRecorded(long vid, long position) {
+        std::lock_guard<std::mutex> guard(locks[vid]);
+        if (position == recorded[vid].size()) {
+            newEdge e;
+            #pragma omp critical(shared_exploration)
+            {
+                e = base->getEdge(vid);
+            }
+            if (e.exists) {
+                recorded[vid].push_back(e);
+            }
+            return e;
+        }
+        return recorded[vid][position];
+    }
+
+    bool isComplete(long vid, long position) {
+        std::lock_guard<std::mutex> guard(locks[vid]);
+        return position == recorded[vid].size() && base->isComplete(vid);
+    }
+
+    /*
+     * Number of edges generated for all sources so far
+     */
+    long size() {
+        long total = 0;
+        for (long i = 0; i < n; i++) {
+            std::lock_guard<std::mutex> guard(locks[i]);
+            total += recorded[i].size();
+        }
+        return total;
+    }
+
+private:
+    std::vector<newEdges> recorded;
+    std::vector<std::mutex> locks;
+};
+
+/*
+ * Edges of one chooser: a cursor per source over a shared exploration
+ */
+class SharedEdgeGenerator : public EdgeGenerator {
+public:
+    SharedExploration* exploration;
+    std::vector<long> cursor;
+
+    SharedEdgeGenerator(SharedExploration* exploration) {
+        this->exploration = exploration;
+        this->n = exploration->n;
+        this->m = exploration->m;
+        reset();
+    }
+    ~SharedEdgeGenerator() {}
+
+    bool isComplete(long vid) override {
+        return exploration->isComplete(vid, cursor[vid]);
+    }
+
+    newEdge getEdge(long vid) override {
+        newEdge e;
+        e.exists = false;
+        if (vid < this->n) {
+            e = exploration->getRecorded(vid, cursor[vid]);
+            if (e.exists) {
+                cursor[vid]++;
+            }
+        }
+        return e;
+    }
+
+    newEdge getNearestEdge(long vid) override {
+        if (vid < this->n && cursor[vid] > 0) {
+            return exploration->getRecorded(vid, 0);
+        }
+        newEdge none;
+        none.exists = false;
+        return none;
+    }
+
+    void reset() override {
+        cursor.assign(this->n, 0);
+    }
+};
+
+#endif //FCLA_SHAREDEXPLORATION_H
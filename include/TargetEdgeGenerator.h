@@ -15,8 +15,7 @@
 
 class TargetEdgeGenerator : public EdgeGenerator {
 public:
-    Matcher<long,long,long>* matcher;
-    EdgeGenerator* edge_explorer;
+    EdgeGenerator* edge_explorer; //edge generator of a matcher
     std::vector<long> target_indexes;
 
     //this contains flags whether all targets in bipartite graph are already thrown by this generator
@@ -26,8 +25,8 @@ public:
     std::vector<long> is_target;
 
     //because we must have weights
-    TargetEdgeGenerator(Matcher<long,long,long>* matcher, std::vector<long>& target_indexes) {
-        this->matcher = matcher;
+    template<typename M>
+    TargetEdgeGenerator(M* matcher, std::vector<long>& target_indexes) {
         this->edge_explorer = matcher->edge_generator;
         this->target_indexes = target_indexes;
 
@@ -43,7 +42,7 @@ public:
         //no outgoing edges needed anymore
         if (isComplete(vid)) {
             new_edge.exists = false;
-            edgeMemory.push_back(new_edge);
+            rememberEdge(new_edge);
             return new_edge;
         }
         this->targets_reached[vid]++;
@@ -51,19 +50,19 @@ public:
         if (edgeQueue[vid].size() > 0) {
             new_edge = edgeQueue[vid].back();
             edgeQueue[vid].pop_back();
-            edgeMemory.push_back(new_edge);
+            rememberEdge(new_edge);
             return new_edge;
         }
         //continue exploring
         while (true) {
             new_edge = edge_explorer->getEdge(vid);
             if (!new_edge.exists) {
-                edgeMemory.push_back(new_edge);
+                rememberEdge(new_edge);
                 return new_edge;
             }
             if (is_target[new_edge.target_node - this->n] > -1) {
                 new_edge.target_node = this->edge_explorer->n + is_target[new_edge.target_node - this->n];
-                edgeMemory.push_back(new_edge);
+                rememberEdge(new_edge);
                 return new_edge;
             }
         }
@@ -80,7 +79,7 @@ public:
          * in bipartite graph in matcher. so, in general non-network case, the right side is a set of all potential locations
          * and only id of a potential location can be returned by a generator
          */
-        is_target.resize(this->matcher->edge_generator->m,-1); //size of bipartite is size of sources plus targets
+        is_target.resize(this->edge_explorer->m,-1); //size of bipartite is size of sources plus targets
         for (long i = 0; i < target_indexes.size(); i++) {
             is_target[target_indexes[i]] = i;
         }
@@ -94,8 +93,8 @@ public:
         edgeQueue.resize(this->n, empty_vec);
 
         //traverse all memorized edges and add those which are relevant to the current targets
-        for (long i = 0; i < this->matcher->edge_generator->edgeMemory.size(); i++) {
-            newEdge e = this->matcher->edge_generator->edgeMemory[i];
+        for (long i = 0; i < this->edge_explorer->edgeMemory.size(); i++) {
+            newEdge e = this->edge_explorer->edgeMemory[i];
             if (is_target[e.target_node - this->n] > -1) {
                 e.target_node = this->n + is_target[e.target_node - this->n];
                 edgeQueue[e.source_node].push_back(e);
@@ -7,8 +7,8 @@
 
 #include "ExploringEdgeGenerator.h"
 
-template<typename I, typename W>
-class TargetExploringEdgeGenerator : public ExploringEdgeGenerator<I,W> {
+template<typename I, typename W, typename H = GeneratorHeapPolicy>
+class TargetExploringEdgeGenerator : public ExploringEdgeGenerator<I,W,H> {
 public:
     std::vector<bool> is_target;
     std::vector<long> reverse_index;
@@ -22,7 +22,12 @@ public:
     }
 
     TargetExploringEdgeGenerator(Network& network,
-                                 std::vector<long>& target_indexes) : ExploringEdgeGenerator<I,W>(network) {
+                                 std::vector<long>& target_indexes) :
+            TargetExploringEdgeGenerator(network, network.source_indexes, target_indexes) {}
+
+    TargetExploringEdgeGenerator(Network& network,
+                                 std::vector<long>& source_indexes,
+                                 std::vector<long>& target_indexes) : ExploringEdgeGenerator<I,W,H>(network, source_indexes) {
         this->m = target_indexes.size();
         this->buffer.resize(this->n);
         is_target.resize(igraph_vcount(&network.graph),false);
@@ -35,6 +40,11 @@ public:
         this->reset();
     }
 
+    void relocateSource(long vid, long node) override {
+        ExploringEdgeGenerator<I,W,H>::relocateSource(vid, node);
+        updateBuffer(vid);
+    }
+
     long get_facility_id_by_node_id(long node_id) {
         return this->reverse_index[node_id];
     }
@@ -66,7 +76,7 @@ public:
 //                        }
 //                    }
 
-                    this->edgeMemory.push_back(e);
+                    this->rememberEdge(e);
                     break;
                 }
             }
@@ -10,8 +10,10 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <random>
+#include <memory>
 #include <igraph/igraph.h>
 #include <lemon/list_graph.h>
+#include "Network.h"
 
 #define WEIGHT_ERROR 0.001
 
@@ -55,6 +57,25 @@ int generate_random_geometric_graph(long size,
     return res; //error code from igraph generator
 }
 
+/*
+ * Network on a random geometric graph with a customer at every <customer_step>-th node, for tests
+ */
+std::unique_ptr<Network> generate_random_geometric_network(long size, double density, long customer_step) {
+    igraph_t graph;
+    std::vector<long> weights;
+    igraph_vector_t x, y;
+    generate_random_geometric_graph(size, density, &graph, weights, &x, &y);
+    std::vector<long> sources;
+    for (long i = 0; i < size; i += customer_step) {
+        sources.push_back(i);
+    }
+    std::unique_ptr<Network> network(new Network(&graph, weights, sources)); //the network keeps a copy of the graph
+    igraph_vector_destroy(&x);
+    igraph_vector_destroy(&y);
+    igraph_destroy(&graph);
+    return network;
+}
+
 /*
  * Make directed graph, input initialized
  */
@@ -48,6 +48,17 @@ public:
         num_elems = 0;
     }
 
+    /*
+     * Empty the heap keeping the allocated index: only positions of elements left in the heap are reset,
+     * so the cost is proportional to the heap size and not to the largest idx ever enqueued
+     */
+    void softClear() {
+        for (I i = 0; i < num_elems; i++) {
+            order[heap[i].idx] = -1;
+        }
+        num_elems = 0;
+    }
+
     bool isExisted(I idx, V &v) {
         if (num_elems>0 && idx<order.size() && order[idx]!=-1) {
             v=heap[order[idx]].value;
@@ -86,7 +97,7 @@ public:
         {
             I pos = order[idx];
             order[idx] = -1;
-            if (num_elems - 1 > 0)
+            if (pos != num_elems - 1) //the last element is removed without moving anything
             {
                 order[heap[num_elems-1].idx] = pos;
                 heap[pos].idx = heap[num_elems-1].idx;
@@ -4,42 +4,189 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <boost/program_options.hpp>
 
 #include "helpers.h"
 #include "Network.h"
 #include "FacilityChooser.h"
+#include "SharedExploration.h"
 #include "igraph/igraph.h"
 #include "Logger.h"
 
 using namespace std;
 namespace po = boost::program_options;
 
-int main(int argc, const char** argv) {
-    string filename;
+/*
+ * Parameters of FacilityChooser from the command line
+ */
+struct ChooserOptions {
     long facilities_to_locate;
     long facility_capacity;
     long lambda;
     double alpha;
+    bool pace_backoff;
     bool partially_uniform;
     int greedy_matching;
     int objective_matching;
+    long greedy_chunk;
+    bool greedy_deterministic;
+    bool batched_matching;
+    bool warm_start_matching;
+    double epsilon;
+    bool auction_objective;
+    long objective_parts;
+    long bitset_density;
+    double cover_epsilon;
+    double time_budget;
+    long iteration_budget;
+    long anytime_period;
+};
+
+template<typename Chooser>
+void configure(Chooser& fcla, ChooserOptions& options) {
+    fcla.pace_backoff = options.pace_backoff;
+    fcla.greedyMatching = options.greedy_matching != 0;
+    fcla.objective_matching = options.objective_matching;
+    fcla.greedyMatchingOrder = options.greedy_matching;
+    fcla.greedyChunk = options.greedy_chunk;
+    fcla.greedyDeterministic = options.greedy_deterministic;
+    fcla.batchedMatching = options.batched_matching;
+    fcla.warmStartMatching = options.warm_start_matching;
+    fcla.epsilon = options.epsilon;
+    fcla.auction_objective = options.auction_objective;
+    fcla.objective_parts = options.objective_parts;
+    fcla.bitset_min_density = options.bitset_density;
+    fcla.parallel_cover_epsilon = options.cover_epsilon;
+    fcla.time_budget = options.time_budget;
+    fcla.iteration_budget = options.iteration_budget;
+    fcla.anytime_period = options.anytime_period;
+}
+
+template<typename Chooser>
+void locate(Network& net, ChooserOptions& options, Logger& logger) {
+    Chooser fcla(net, options.facilities_to_locate, options.facility_capacity, &logger, options.lambda, options.alpha, options.partially_uniform);
+    configure(fcla, options);
+    fcla.run();
+    switch(fcla.state) {
+        case Chooser::LOCATED:
+            cout << logger.float_dict["objective"][0] << " " << logger.float_dict["runtime"][0] << endl;
+            break;
+        default:
+            cout << "Error " << logger.str_dict["error"][0] << endl;
+    }
+}
+
+/*
+ * Output file of one configuration of a sweep: <prefix>_n<facilities>_c<capacity>_l<lambda>.json
+ */
+string sweep_filename(string& prefix, ChooserOptions& options) {
+    std::ostringstream filename;
+    filename << prefix << "_n" << options.facilities_to_locate << "_c" << options.facility_capacity
+             << "_l" << options.lambda << ".json";
+    return filename.str();
+}
+
+/*
+ * Solve every combination of facilities, capacities and lambdas on one network.
+ * Configurations run in parallel on the OpenMP threads and replay one shared exploration of the network,
+ * so the nearest facilities of a customer are found only once for the whole grid, see SharedExploration.h
+ * Parallel regions inside of a chooser run on one thread unless nested parallelism is enabled
+ */
+template<typename Chooser>
+void sweep(Network& net, ChooserOptions& options, vector<long>& facilities, vector<long>& capacities,
+           vector<long>& lambdas, string& out_prefix, Logger& logger) {
+    vector<ChooserOptions> grid;
+    for (long k : facilities) {
+        for (long capacity : capacities) {
+            for (long lambda : lambdas) {
+                ChooserOptions config = options;
+                config.facilities_to_locate = k;
+                config.facility_capacity = capacity;
+                config.lambda = lambda;
+                grid.push_back(config);
+            }
+        }
+    }
+    logger.add("sweep configurations", grid.size());
+    logger.start("sweep time");
+
+    EdgeGenerator* explorer = Chooser::createEdgeGenerator(net);
+    SharedExploration exploration(explorer);
+    if (net.coords.size() > 0) {
+        net.get_hilbert_keys(); //cached before choosers read it in parallel
+    }
+
+    vector<string> lines(grid.size());
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (long i = 0; i < grid.size(); i++) {
+        ChooserOptions& config = grid[i];
+        Logger config_logger;
+        std::ostringstream line;
+        line << config.facilities_to_locate << " " << config.facility_capacity << " " << config.lambda << " ";
+        try {
+            Chooser fcla(net, config.facilities_to_locate, config.facility_capacity, &config_logger, config.lambda,
+                         config.alpha, config.partially_uniform, &exploration);
+            configure(fcla, config);
+            fcla.run();
+            line << config_logger.float_dict["objective"][0] << " " << config_logger.float_dict["runtime"][0];
+        } catch (const std::exception& e) {
+            config_logger.add("error", e.what());
+            line << "Error " << e.what();
+        } catch (const std::string& e) {
+            config_logger.add("error", e);
+            line << "Error " << e;
+        }
+        config_logger.save(sweep_filename(out_prefix, config));
+        lines[i] = line.str();
+    }
+    for (auto& line : lines) {
+        cout << line << endl;
+    }
+
+    logger.add("shared edges", exploration.size());
+    logger.finish("sweep time");
+    delete explorer;
+}
+
+int main(int argc, const char** argv) {
+    string filename;
+    ChooserOptions options;
     string out_filename;
     string facilityfilename;
+    vector<long> sweep_facilities;
+    vector<long> sweep_capacities;
+    vector<long> sweep_lambdas;
 
     po::options_description desc("Allowed options");
     desc.add_options()
             ("help,h", "produce help message")
             ("input,i", po::value<string>(&filename)->required(), "Input file, a network")
             ("facilityfile,f", po::value<string>(&facilityfilename)->default_value(""), "List of potential facilities")
-            ("facilities,n", po::value<long>(&facilities_to_locate)->required(), "Facilities to locate")
-            ("faccap,c", po::value<long>(&facility_capacity)->default_value(1), "Capacity of facilities")
-            ("lambda,l", po::value<long>(&lambda)->default_value(0), "Parameter lambda, set cover oversize")
-            ("alpha,a", po::value<double>(&alpha)->default_value(1), "Parameter alpha, exploring pace")
-            ("partuni,p", po::value<bool>(&partially_uniform)->default_value(false), "Calculate objective by non-uni cap and assignment by uniform cap")
-            ("greedy,g", po::value<int>(&greedy_matching)->default_value(0), "Perform greedy matching, 0 - disabled, 1 - random, 2 - hilbert, 3 - distance")
-            ("matching,m", po::value<int>(&objective_matching)->default_value(1), "0 - SIA objective, 1 - greedy matching objective if -g specified (default)")
-            ("output,o", po::value<string>(&out_filename)->required(), "Output file");
+            ("facilities,n", po::value<long>(&options.facilities_to_locate)->required(), "Facilities to locate")
+            ("faccap,c", po::value<long>(&options.facility_capacity)->default_value(1), "Capacity of facilities")
+            ("lambda,l", po::value<long>(&options.lambda)->default_value(0), "Parameter lambda, set cover oversize")
+            ("alpha,a", po::value<double>(&options.alpha)->default_value(0), "Parameter alpha, exploring pace: uncovered customers increase demand by alpha*(uncovered share) of it, 0 - by one")
+            ("backoff,x", po::value<bool>(&options.pace_backoff)->default_value(false), "Double the exploring pace while the cover does not grow, halve it when it grows")
+            ("partuni,p", po::value<bool>(&options.partially_uniform)->default_value(false), "Calculate objective by non-uni cap and assignment by uniform cap")
+            ("greedy,g", po::value<int>(&options.greedy_matching)->default_value(0), "Perform greedy matching, 0 - disabled, 1 - random, 2 - hilbert, 3 - distance")
+            ("matching,m", po::value<int>(&options.objective_matching)->default_value(1), "0 - SIA objective, 1 - greedy matching objective if -g specified (default)")
+            ("chunk,k", po::value<long>(&options.greedy_chunk)->default_value(0), "Greedy matching of that many customers in parallel, 0 - sequential")
+            ("deterministic,d", po::value<bool>(&options.greedy_deterministic)->default_value(true), "Parallel greedy gives the result of the sequential one, otherwise capacities are claimed atomically")
+            ("batched,b", po::value<bool>(&options.batched_matching)->default_value(false), "Match increased demands of all customers together in SIA phases")
+            ("warm,w", po::value<bool>(&options.warm_start_matching)->default_value(false), "Reuse zero reduced cost paths of previous SIA iterations before Dijkstra")
+            ("epsilon,e", po::value<double>(&options.epsilon)->default_value(0), "Accept SIA paths up to (1+epsilon) times longer than the shortest, logs the certified gap")
+            ("auction,u", po::value<bool>(&options.auction_objective)->default_value(false), "Calculate SIA objective with the auction algorithm")
+            ("parts,t", po::value<long>(&options.objective_parts)->default_value(0), "Calculate SIA objective in that many spatial parts in parallel, 0 - disabled")
+            ("bitset,s", po::value<long>(&options.bitset_density)->default_value(4), "Set cover keeps customers of a facility as a bitmap if there are that many per 64 customer ids, 0 - never")
+            ("cover,v", po::value<double>(&options.cover_epsilon)->default_value(0), "Parallel greedy set cover with gain buckets of (1+v), 0 - sequential lazy greedy")
+            ("budget", po::value<double>(&options.time_budget)->default_value(0), "Seconds for WMA, then the partial cover is completed and evaluated, 0 - unlimited")
+            ("iterations", po::value<long>(&options.iteration_budget)->default_value(0), "WMA iterations, then the partial cover is completed and evaluated, 0 - unlimited")
+            ("anytime", po::value<long>(&options.anytime_period)->default_value(0), "Evaluate and log the partial cover every that many WMA iterations and return the best one, 0 - about ten times within --budget or --iterations, -1 - never")
+            ("sweepn", po::value<vector<long>>(&sweep_facilities)->multitoken(), "Sweep over these numbers of facilities instead of -n")
+            ("sweepc", po::value<vector<long>>(&sweep_capacities)->multitoken(), "Sweep over these capacities instead of -c")
+            ("sweepl", po::value<vector<long>>(&sweep_lambdas)->multitoken(), "Sweep over these lambdas instead of -l")
+            ("output,o", po::value<string>(&out_filename)->required(), "Output file, a prefix of files of configurations in a sweep");
 
     po::variables_map vm;
     po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -56,20 +203,35 @@ int main(int argc, const char** argv) {
         Network net(filename, facilityfilename);
         logger.finish2("reading file");
 
-        FacilityChooser fcla(net, facilities_to_locate, facility_capacity, &logger, lambda, alpha, partially_uniform);
-        fcla.greedyMatching = greedy_matching != 0;
-        fcla.objective_matching = objective_matching;
-        fcla.greedyMatchingOrder = greedy_matching;
-        fcla.run();
-        switch(fcla.state) {
-            case FacilityChooser::LOCATED:
-                cout << logger.float_dict["objective"][0] << " " << logger.float_dict["runtime"][0] << endl;
-                break;
-            default:
-                cout << "Error " << logger.str_dict["error"][0] << endl;
+        bool sweeping = sweep_facilities.size() + sweep_capacities.size() + sweep_lambdas.size() > 0;
+        if (sweep_facilities.empty()) {
+            sweep_facilities.push_back(options.facilities_to_locate);
+        }
+        if (sweep_capacities.empty()) {
+            sweep_capacities.push_back(options.facility_capacity);
+        }
+        if (sweep_lambdas.empty()) {
+            sweep_lambdas.push_back(options.lambda);
+        }
+
+        //32-bit ids and weights of the matching if the network is small enough
+        if (FacilityChooser32::fitsNetwork(net)) {
+            logger.add("index bits", 32);
+            if (sweeping) {
+                sweep<FacilityChooser32>(net, options, sweep_facilities, sweep_capacities, sweep_lambdas, out_filename, logger);
+            } else {
+                locate<FacilityChooser32>(net, options, logger);
+            }
+        } else {
+            logger.add("index bits", 64);
+            if (sweeping) {
+                sweep<FacilityChooser>(net, options, sweep_facilities, sweep_capacities, sweep_lambdas, out_filename, logger);
+            } else {
+                locate<FacilityChooser>(net, options, logger);
+            }
         }
         logger.finish("total time");
-        logger.save(out_filename);
+        logger.save(sweeping ? out_filename + "_sweep.json" : out_filename);
     } catch (const std::string& e) {
         std::cout << e << std::endl;
     }
@@ -43,8 +43,16 @@ int main(int argc, const char** argv) {
     logger.start("total time");
 
     Network net(filename, facilityfile);
-    NLR nlr_solver = NLR(net, &logger, facility_capacity, facility_number_to_locate);
-    nlr_solver.run();
+    //32-bit ids and weights of the matching if the network is small enough
+    if (Matcher<long,int32_t,int32_t>::fitsNetwork(net)) {
+        logger.add("index bits", 32);
+        NLR32 nlr_solver(net, &logger, facility_capacity, facility_number_to_locate);
+        nlr_solver.run();
+    } else {
+        logger.add("index bits", 64);
+        NLR nlr_solver(net, &logger, facility_capacity, facility_number_to_locate);
+        nlr_solver.run();
+    }
     logger.save(out_filename);
 
     if (logger.str_dict.count("error") > 0) {
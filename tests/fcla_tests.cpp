@@ -6,6 +6,7 @@
 #define BOOST_TEST_DYN_LINK
 #include <boost/test/unit_test.hpp>
 #include <algorithm>
+#include <set>
 #include "EdgeGenerator.h"
 #include "helpers.h"
 #include "ExploringEdgeGenerator.h"
@@ -254,4 +255,310 @@ BOOST_AUTO_TEST_CASE (lonelyCustomerInTwoComponentGraphExceptionExpected) {
 
     FacilityChooser fcla2(net, 2, 1, &logger);
     BOOST_CHECK_THROW(fcla2.locateFacilities(), NoMoreCapacitiesToIncrease);
-}
\ No newline at end of file
+}
+BOOST_AUTO_TEST_CASE (narrowIndexAndWeightTypes) {
+    std::unique_ptr<Network> network = generate_random_geometric_network(200, 0.15, 4);
+    Network& net = *network;
+    BOOST_CHECK(FacilityChooser32::fitsNetwork(net));
+    BOOST_CHECK(!(Matcher<long,int16_t,int16_t>::fitsNetwork(net))); //the extra node weight does not fit
+
+    Logger logger;
+    FacilityChooser wide(net, 10, 6, &logger);
+    wide.run();
+    FacilityChooser32 narrow(net, 10, 6, &logger);
+    narrow.run();
+    BOOST_CHECK_EQUAL(narrow.totalCost, wide.totalCost);
+    BOOST_CHECK_EQUAL_COLLECTIONS(narrow.result.begin(), narrow.result.end(), wide.result.begin(), wide.result.end());
+
+    //paths may be longer than 32-bit distances allow
+    std::vector<long> long_weights(net.weights.size(), std::numeric_limits<int32_t>::max() / 8);
+    Network long_net(&net.graph, long_weights, net.source_indexes);
+    BOOST_CHECK(!FacilityChooser32::fitsNetwork(long_net));
+    BOOST_CHECK(FacilityChooser::fitsNetwork(long_net));
+}
+
+BOOST_AUTO_TEST_CASE (incrementalSetCover) {
+    std::unique_ptr<Network> network = generate_random_geometric_network(200, 0.15, 4);
+    Network& net = *network;
+
+    //the set cover updated by changes of the matching is the same as the one built from scratch
+    Logger logger;
+    FacilityChooser incremental(net, 10, 6, &logger);
+    FacilityChooser rebuilt(net, 10, 6, &logger);
+    incremental.match();
+    rebuilt.match();
+    std::vector<int> incremental_complete(net.source_indexes.size(), 0);
+    std::vector<int> rebuilt_complete(net.source_indexes.size(), 0);
+    for (long iteration = 0; iteration < 20; iteration++) {
+        rebuilt.coverage_ready = false;
+        bool incremental_found = incremental.findSetCover();
+        BOOST_CHECK_EQUAL(rebuilt.findSetCover(), incremental_found);
+        BOOST_CHECK_EQUAL_COLLECTIONS(rebuilt.result.begin(), rebuilt.result.end(),
+                                      incremental.result.begin(), incremental.result.end());
+        BOOST_CHECK_EQUAL_COLLECTIONS(rebuilt.customer_antirank.begin(), rebuilt.customer_antirank.end(),
+                                      incremental.customer_antirank.begin(), incremental.customer_antirank.end());
+        if (incremental_found) {
+            break;
+        }
+        incremental.capacity_iteration++;
+        rebuilt.capacity_iteration++;
+        BOOST_CHECK_EQUAL(rebuilt.increaseCapacities(rebuilt_complete), incremental.increaseCapacities(incremental_complete));
+    }
+}
+
+BOOST_AUTO_TEST_CASE (setCoverTieOrder) {
+    //on a grid with unit weights many facilities have equal coverage, ties by id prefer one corner of the grid
+    //and need about twice as many iterations of capacities
+    long side = 20;
+    std::vector<long> edges;
+    std::vector<long> weights;
+    for (long r = 0; r < side; r++) {
+        for (long c = 0; c < side; c++) {
+            long v = r * side + c;
+            if (c + 1 < side) {
+                edges.push_back(v);
+                edges.push_back(v + 1);
+                weights.push_back(1);
+            }
+            if (r + 1 < side) {
+                edges.push_back(v);
+                edges.push_back(v + side);
+                weights.push_back(1);
+            }
+        }
+    }
+    std::vector<long> sources;
+    for (long i = 0; i < side * side; i += 2) {
+        sources.push_back(i);
+    }
+    igraph_t graph;
+    create_graph(&graph, side * side, edges);
+    Network net(&graph, weights, sources);
+
+    Logger logger;
+    FacilityChooser fcla(net, 2 * side, 7, &logger);
+    fcla.run();
+    BOOST_CHECK_LT(logger.float_dict["number of iterations"][0], 50);
+
+    igraph_destroy(&graph);
+}
+
+BOOST_AUTO_TEST_CASE (bitsetCoverage) {
+    std::unique_ptr<Network> network = generate_random_geometric_network(400, 0.1, 2);
+    Network& net = *network;
+
+    //the set cover does not depend on the representation of matched customers
+    Logger logger;
+    FacilityChooser arrays(net, 20, 12, &logger);
+    arrays.bitset_min_density = 0;
+    arrays.run();
+    FacilityChooser bitmaps(net, 20, 12, &logger);
+    bitmaps.bitset_min_density = 1;
+    bitmaps.run();
+    BOOST_CHECK_EQUAL(bitmaps.totalCost, arrays.totalCost);
+    BOOST_CHECK_EQUAL_COLLECTIONS(bitmaps.result.begin(), bitmaps.result.end(), arrays.result.begin(), arrays.result.end());
+
+    //a bitmap loses covered customers and counts the rest
+    std::vector<uint64_t> facility = {0xF0F0ULL, 0x1ULL, ~0ULL};
+    std::vector<uint64_t> covered = {0x00F0ULL, 0x1ULL, 0xFFFFFFFFULL};
+    BOOST_CHECK_EQUAL(subtract_covered_bits(facility.data(), covered.data(), 3), 4 + 0 + 32);
+    std::vector<long> customers;
+    for_each_bit(facility.data(), 1, 1, [&](long customer) { customers.push_back(customer); });
+    BOOST_CHECK_EQUAL(customers.size(), 4);
+    BOOST_CHECK_EQUAL(customers[0], 64 + 12);
+}
+
+BOOST_AUTO_TEST_CASE (parallelSetCover) {
+    std::unique_ptr<Network> network = generate_random_geometric_network(400, 0.1, 2);
+    Network& net = *network;
+
+    //with narrow gain buckets the parallel cover chooses what the sequential lazy greedy chooses
+    Logger logger;
+    FacilityChooser sequential(net, 20, 12, &logger);
+    FacilityChooser narrow(net, 20, 12, &logger);
+    narrow.parallel_cover_epsilon = 1e-9;
+    sequential.match();
+    narrow.match();
+    BOOST_CHECK_EQUAL(narrow.findSetCover(), sequential.findSetCover());
+    BOOST_CHECK_EQUAL_COLLECTIONS(narrow.result.begin(), narrow.result.end(), sequential.result.begin(), sequential.result.end());
+    BOOST_CHECK_EQUAL(narrow.total_covered, sequential.total_covered);
+
+    FacilityChooser wide(net, 20, 12, &logger);
+    wide.parallel_cover_epsilon = 0.5;
+    wide.run();
+    BOOST_CHECK(wide.state == FacilityChooser::LOCATED);
+    BOOST_CHECK_EQUAL(wide.result.size(), 20);
+    std::set<long> distinct(wide.result.begin(), wide.result.end());
+    BOOST_CHECK_EQUAL(distinct.size(), 20);
+}
+
+BOOST_AUTO_TEST_CASE (adaptivePace) {
+    std::unique_ptr<Network> network = generate_random_geometric_network(400, 0.1, 2);
+    Network& net = *network;
+
+    //demands of uncovered customers grow geometrically, so WMA needs fewer iterations
+    Logger unit_logger;
+    FacilityChooser unit(net, 20, 12, &unit_logger);
+    unit.run();
+    Logger paced_logger;
+    FacilityChooser paced(net, 20, 12, &paced_logger, 0, 2);
+    paced.pace_backoff = true;
+    paced.run();
+    BOOST_CHECK(paced.state == FacilityChooser::LOCATED);
+    BOOST_CHECK_EQUAL(paced.result.size(), 20);
+    BOOST_CHECK_EQUAL(paced_logger.float_dict["alpha"][0], 2);
+    BOOST_CHECK_LT(paced_logger.float_dict["number of iterations"][0], unit_logger.float_dict["number of iterations"][0]);
+    BOOST_CHECK_GT(paced_logger.float_dict["demand increment"].size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE (locateRestFromNearestFacilities) {
+    std::unique_ptr<Network> network = generate_random_geometric_network(200, 0.15, 2);
+    Network& net = *network;
+
+    Logger logger;
+    FacilityChooser unit(net, 10, 20, &logger);
+    unit.run();
+    BOOST_CHECK(unit.state == FacilityChooser::LOCATED);
+
+    //keep one facility, the rest is chosen among nearest facilities of customers
+    unit.result.resize(1);
+    unit.locateRest();
+    BOOST_CHECK_EQUAL(unit.result.size(), 10);
+    std::set<long> chosen(unit.result.begin(), unit.result.end());
+    BOOST_CHECK_EQUAL(chosen.size(), 10);
+    std::set<long> requested;
+    for (long i = 0; i < unit.source_count; i++) {
+        newEdge e = unit.edge_generator->getNearestEdge(i);
+        BOOST_CHECK(e.exists);
+        requested.insert(e.target_node - unit.edge_generator->n);
+    }
+    if (requested.size() >= 10) {
+        for (long i = 1; i < unit.result.size(); i++) {
+            BOOST_CHECK(requested.count(unit.result[i]));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE (sharedExplorationSweep) {
+    std::unique_ptr<Network> network = generate_random_geometric_network(200, 0.15, 2);
+    Network& net = *network;
+
+    //configurations replay one exploration of the network in parallel and give the same results as alone
+    std::vector<std::pair<long,long>> grid = {{10, 12}, {10, 20}, {15, 8}, {20, 6}, {25, 5}};
+    EdgeGenerator* explorer = FacilityChooser::createEdgeGenerator(net);
+    SharedExploration exploration(explorer);
+    std::vector<long> shared_costs(grid.size());
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (long i = 0; i < grid.size(); i++) {
+        Logger logger;
+        FacilityChooser shared(net, grid[i].first, grid[i].second, &logger, 0, 0, false, &exploration);
+        shared.run();
+        shared_costs[i] = shared.totalCost;
+    }
+    long alone_edges = 0;
+    for (long i = 0; i < grid.size(); i++) {
+        Logger logger;
+        FacilityChooser alone(net, grid[i].first, grid[i].second, &logger);
+        alone.run();
+        BOOST_CHECK_EQUAL(shared_costs[i], alone.totalCost);
+        alone_edges = std::max(alone_edges, (long) alone.edge_generator->edgeMemory.size());
+    }
+    BOOST_CHECK_EQUAL(exploration.size(), explorer->edgeMemory.size());
+    BOOST_CHECK_GE(exploration.size(), alone_edges);
+    delete explorer;
+}
+
+BOOST_AUTO_TEST_CASE (anytimeBudget) {
+    std::unique_ptr<Network> network = generate_random_geometric_network(400, 0.1, 2);
+    Network& net = *network;
+
+    Logger full_logger;
+    FacilityChooser full(net, 20, 12, &full_logger);
+    full.run();
+    long full_iterations = full_logger.float_dict["number of iterations"][0];
+    BOOST_CHECK_GT(full_iterations, 10);
+
+    //WMA stops at the budget with a complete result, intermediate objectives are logged
+    Logger logger;
+    FacilityChooser unit(net, 20, 12, &logger);
+    unit.iteration_budget = full_iterations / 2;
+    unit.anytime_period = 3;
+    unit.run();
+    BOOST_CHECK(unit.state == FacilityChooser::LOCATED);
+    BOOST_CHECK_EQUAL(unit.result.size(), 20);
+    BOOST_CHECK_EQUAL(std::set<long>(unit.result.begin(), unit.result.end()).size(), 20);
+    BOOST_CHECK_EQUAL(logger.float_dict["budget exhausted"][0], full_iterations / 2);
+    BOOST_CHECK_EQUAL(logger.float_dict["number of iterations"][0], full_iterations / 2);
+    std::vector<double>& objectives = logger.float_dict["anytime objective"];
+    BOOST_CHECK_EQUAL(objectives.size(), full_iterations / 2 / 3 + 1);
+    BOOST_CHECK_EQUAL(logger.float_dict["anytime seconds"].size(), objectives.size());
+    BOOST_CHECK_EQUAL(unit.totalCost, *std::min_element(objectives.begin(), objectives.end()));
+    BOOST_CHECK_EQUAL(logger.float_dict["objective"].size(), 1);
+
+    //a budget alone logs about ten intermediate objectives
+    Logger budget_logger;
+    FacilityChooser budget(net, 20, 12, &budget_logger);
+    budget.iteration_budget = full_iterations / 2;
+    budget.run();
+    long period = std::max(1L, full_iterations / 2 / 10);
+    std::vector<double>& budget_objectives = budget_logger.float_dict["anytime objective"];
+    BOOST_CHECK_EQUAL(budget_objectives.size(), full_iterations / 2 / period + 1);
+    BOOST_CHECK_EQUAL(budget.totalCost, *std::min_element(budget_objectives.begin(), budget_objectives.end()));
+    //the objective is reused from the evaluation of the best cover instead of matching it again
+    std::vector<long> final_excess;
+    BOOST_CHECK_EQUAL(budget.evaluateResult(final_excess), budget.totalCost);
+    BOOST_CHECK(final_excess == budget.best_excess);
+}
+
+BOOST_AUTO_TEST_CASE (dynamicCustomers) {
+    std::unique_ptr<Network> network = generate_random_geometric_network(200, 0.15, 2);
+    Network& net = *network;
+    std::vector<long> sources = net.source_indexes;
+
+    Logger logger;
+    FacilityChooser unit(net, 10, 12, &logger);
+    BOOST_CHECK_THROW(unit.removeCustomer(0), std::logic_error);
+    unit.run();
+
+    //customers leave, arrive into their slots and move, facilities change capacities
+    for (long i = 0; i < 20; i++) {
+        unit.removeCustomer(i * 5);
+    }
+    BOOST_CHECK_EQUAL(unit.removed_customers, 20);
+    for (long i = 0; i < 5; i++) {
+        long customer = unit.addCustomer(i * 2 + 1);
+        BOOST_CHECK(!unit.isRemovedCustomer(customer));
+        BOOST_CHECK_EQUAL(unit.source_indexes[customer], i * 2 + 1);
+    }
+    for (long i = 0; i < 5; i++) {
+        unit.relocateCustomer(i * 5 + 1, (sources[i * 5 + 1] + 1) % net.graph_size());
+    }
+    unit.setFacilityCapacity(unit.result[0], 20);
+    BOOST_CHECK_EQUAL(unit.removed_customers, 15);
+    for (long i = 0; i < unit.source_count; i++) {
+        BOOST_CHECK_GE(unit.node_excess[i], 0);
+    }
+
+    long cost = unit.update();
+    BOOST_CHECK(unit.state == FacilityChooser::LOCATED);
+    BOOST_CHECK_EQUAL(unit.result.size(), 10);
+    BOOST_CHECK_EQUAL(cost, unit.totalCost);
+    BOOST_CHECK_EQUAL(logger.float_dict["update time"].size(), 1);
+
+    //the shared network is not changed, the objective is the one of the located facilities for the moved customers
+    BOOST_CHECK(net.source_indexes == sources);
+    std::vector<long> located = unit.result;
+    Network moved(&net.graph, net.weights, unit.source_indexes);
+    FacilityChooser check(moved, 10, 12, &logger);
+    check.result = located;
+    check.target_capacities.assign(check.edge_generator->m, 12);
+    check.target_capacities[located[0]] = 20;
+    check.uniform_capacities = false;
+    for (long i = 0; i < check.source_count; i++) {
+        if (unit.isRemovedCustomer(i)) {
+            check.full_node_excess[i] = 0;
+        }
+    }
+    check.state = FacilityChooser::LOCATED;
+    BOOST_CHECK_EQUAL(check.calculateResult(), cost);
+}
@@ -10,6 +10,8 @@
 #include <igraph/igraph.h>
 #include <iostream>
 #include <Matcher.h>
+#include <AuctionMatcher.h>
+#include <PartitionedMatcher.h>
 #include <algorithm>
 #include <time.h>
 #include <EdgeGenerator.h>
@@ -149,4 +151,535 @@ BOOST_AUTO_TEST_CASE (multicapacityTest) {
         //note that all customers MUST be assigned, so there should be strongly greater number of services
         BOOST_CHECK_EQUAL(testFlowMatchingSD(egg, totalFlow, source_capacities, target_capacity), M.result_weight);
     }
-}
\ No newline at end of file
+}
+BOOST_AUTO_TEST_CASE (loadedEdgeGeneratorReplay) {
+    long source_n = 23;
+    long target_n = 75;
+    RandomEdgeGenerator egg(source_n, source_n, target_n, 1);
+    egg.makeComplete();
+    egg.save("loaded_edges_test.csv");
+    egg.saveBinary("loaded_edges_test.bin");
+
+    std::vector<std::string> files = {"loaded_edges_test.csv", "loaded_edges_test.bin"};
+    for (auto& filename : files) {
+        LoadedEdgeGenerator loaded(filename);
+        BOOST_REQUIRE_EQUAL(loaded.edgeMemory.size(), egg.edgeMemory.size());
+        for (int replay = 0; replay < 2; replay++) {
+            //edges of each source must be thrown in the order they were generated
+            for (long i = 0; i < source_n; i++) {
+                for (long j = 0; j < egg.edgeMemory.size(); j++) {
+                    newEdge expected = egg.edgeMemory[j];
+                    if (expected.source_node != i) continue;
+                    newEdge e = loaded.getEdge(i);
+                    BOOST_REQUIRE(e.exists);
+                    BOOST_CHECK_EQUAL(e.target_node, expected.target_node);
+                    BOOST_CHECK_EQUAL(e.weight, expected.weight);
+                    BOOST_CHECK_EQUAL(e.capacity, expected.capacity);
+                }
+                BOOST_CHECK(!loaded.getEdge(i).exists);
+            }
+            BOOST_CHECK(!loaded.getEdge(source_n).exists);
+            loaded.reset();
+        }
+    }
+    std::remove("loaded_edges_test.csv");
+    std::remove("loaded_edges_test.bin");
+
+    //counts of edges that do not fit a truncated or corrupted file are rejected before allocation
+    std::vector<int64_t> counts = {-1, 1L << 60, (int64_t) egg.edgeMemory.size()};
+    for (int64_t count : counts) {
+        std::ofstream f("loaded_edges_test.bin", std::ofstream::out | std::ofstream::binary);
+        f.write(EDGE_FILE_MAGIC, EDGE_FILE_MAGIC_SIZE);
+        f.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        int64_t record[EDGE_RECORD_FIELDS] = {1, 0, 1, 0, 1};
+        f.write(reinterpret_cast<const char*>(record), sizeof(record));
+        f.close();
+        BOOST_CHECK_THROW(LoadedEdgeGenerator loaded("loaded_edges_test.bin"), const char*);
+    }
+    std::remove("loaded_edges_test.bin");
+}
+
+BOOST_AUTO_TEST_CASE (randomEdgeGeneratorPermutation) {
+    std::vector<long> target_counts = {1, 2, 7, 64, 1000};
+    for (long target_n : target_counts) {
+        long source_n = 10;
+        //sources overlap with targets in order to check that a node is never connected to itself
+        long target_start = 5;
+        RandomEdgeGenerator egg(source_n, target_start, target_n, 1, 17);
+        for (long i = 0; i < source_n; i++) {
+            std::vector<bool> seen(target_n, false);
+            long prev_weight = 0;
+            long count = 0;
+            while (!egg.isComplete(i)) {
+                newEdge e = egg.getEdge(i);
+                BOOST_REQUIRE(e.exists);
+                BOOST_REQUIRE(e.target_node >= target_start && e.target_node < target_start + target_n);
+                BOOST_CHECK(e.target_node != i);
+                BOOST_CHECK(!seen[e.target_node - target_start]);
+                BOOST_CHECK(e.weight >= prev_weight);
+                seen[e.target_node - target_start] = true;
+                prev_weight = e.weight;
+                count++;
+            }
+            BOOST_CHECK(!egg.getEdge(i).exists);
+            BOOST_CHECK_EQUAL(count, (i >= target_start && i < target_start + target_n) ? target_n - 1 : target_n);
+        }
+
+        //the same seed gives the same edges regardless of the order of calls
+        RandomEdgeGenerator other(source_n, target_start, target_n, 1, 17);
+        for (long i = source_n - 1; i >= 0; i--) {
+            while (other.getEdge(i).exists);
+        }
+        for (long j = 0; j < egg.edgeMemory.size(); j++) {
+            newEdge e = egg.edgeMemory[j];
+            long k = 0;
+            while (other.edgeMemory[k].source_node != e.source_node || other.edgeMemory[k].target_node != e.target_node) k++;
+            BOOST_CHECK_EQUAL(other.edgeMemory[k].weight, e.weight);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE (batchedMatching) {
+    long source_n = 40;
+    long target_n = 60;
+    long target_capacity = 2;
+    for (uint64_t seed = 1; seed < 6; seed++) {
+        RandomEdgeGenerator egg(source_n, source_n, target_n, target_capacity, seed);
+        RandomEdgeGenerator batched_egg(source_n, source_n, target_n, target_capacity, seed);
+        std::vector<long> node_excess(source_n + target_n, target_capacity);
+        for (long i = 0; i < source_n; i++) {
+            node_excess[i] = -1;
+        }
+
+        Logger logger;
+        Matcher<long,long,long> M(&egg, node_excess, &logger);
+        M.match();
+        M.calculateResult();
+        Matcher<long,long,long> B(&batched_egg, node_excess, &logger);
+        B.batchedMatching = true;
+        B.match();
+        B.calculateResult();
+        BOOST_REQUIRE_EQUAL(B.result_weight, M.result_weight);
+
+        //increase demand of several customers at once
+        for (long i = 0; i < source_n; i += 3) {
+            M.increaseCapacity(i);
+            BOOST_REQUIRE(B.increaseDemand(i));
+        }
+        BOOST_CHECK(B.matchBatched().empty());
+        M.calculateResult();
+        B.calculateResult();
+        BOOST_CHECK_EQUAL(B.result_weight, M.result_weight);
+        for (long i = 0; i < source_n; i++) {
+            BOOST_CHECK_EQUAL(B.total_matched[i], M.total_matched[i]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE (batchedDemandIncrease) {
+    //facilities with large capacities end many paths of one phase
+    long source_n = 60;
+    long target_n = 30;
+    long target_capacity = 8;
+    for (uint64_t seed = 1; seed < 6; seed++) {
+        RandomEdgeGenerator egg(source_n, source_n, target_n, target_capacity, seed);
+        RandomEdgeGenerator batched_egg(source_n, source_n, target_n, target_capacity, seed);
+        std::vector<long> node_excess(source_n + target_n, target_capacity);
+        for (long i = 0; i < source_n; i++) {
+            node_excess[i] = -1;
+        }
+
+        Logger logger;
+        Matcher<long,long,long> M(&egg, node_excess, &logger);
+        M.match();
+        Matcher<long,long,long> B(&batched_egg, node_excess, &logger);
+        B.batchedMatching = true;
+        B.match();
+
+        //all demand increases of a WMA iteration at once
+        long increases = 0;
+        long searches_before = B.shortest_path_searches;
+        for (long i = 0; i < source_n; i++) {
+            for (long j = 0; j < 2; j++) {
+                M.increaseCapacity(i);
+                BOOST_REQUIRE(B.increaseDemand(i));
+                increases++;
+            }
+        }
+        BOOST_CHECK(B.matchBatched().empty());
+        M.calculateResult();
+        B.calculateResult();
+        BOOST_CHECK_EQUAL(B.result_weight, M.result_weight);
+        BOOST_CHECK_LT((B.shortest_path_searches - searches_before) * 4, increases);
+    }
+}
+
+BOOST_AUTO_TEST_CASE (warmStartMatching) {
+    long source_n = 40;
+    long target_n = 60;
+    long target_capacity = 2;
+    for (uint64_t seed = 1; seed < 6; seed++) {
+        RandomEdgeGenerator egg(source_n, source_n, target_n, target_capacity, seed);
+        RandomEdgeGenerator warm_egg(source_n, source_n, target_n, target_capacity, seed);
+        std::vector<long> node_excess(source_n + target_n, target_capacity);
+        for (long i = 0; i < source_n; i++) {
+            node_excess[i] = -1;
+        }
+
+        Logger logger;
+        Matcher<long,long,long> M(&egg, node_excess, &logger);
+        M.match();
+        Matcher<long,long,long> W(&warm_egg, node_excess, &logger);
+        W.warmStartMatching = true;
+        W.match();
+        //a search that runs out of its budget of arcs falls back to Dijkstra
+        RandomEdgeGenerator bounded_egg(source_n, source_n, target_n, target_capacity, seed);
+        Matcher<long,long,long> B(&bounded_egg, node_excess, &logger);
+        B.warmStartMatching = true;
+        B.warmStartArcBudget = 2;
+        B.match();
+
+        //several rounds of demand increases, as in WMA iterations
+        for (long round = 0; round < 2; round++) {
+            for (long i = round; i < source_n; i += 2) {
+                long flow = M.increaseCapacity(i);
+                BOOST_CHECK_EQUAL(W.increaseCapacity(i), flow);
+                BOOST_CHECK_EQUAL(B.increaseCapacity(i), flow);
+            }
+            M.calculateResult();
+            W.calculateResult();
+            B.calculateResult();
+            BOOST_REQUIRE_EQUAL(W.result_weight, M.result_weight);
+            BOOST_REQUIRE_EQUAL(B.result_weight, M.result_weight);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE (epsilonMatching) {
+    long source_n = 40;
+    long target_n = 30;
+    long target_capacity = 3; //enough for all demands, so the extra node is not used
+    for (uint64_t seed = 1; seed < 6; seed++) {
+        RandomEdgeGenerator egg(source_n, source_n, target_n, target_capacity, seed);
+        RandomEdgeGenerator approximate_egg(source_n, source_n, target_n, target_capacity, seed);
+        std::vector<long> node_excess(source_n + target_n, target_capacity);
+        for (long i = 0; i < source_n; i++) {
+            node_excess[i] = -1;
+        }
+
+        Logger logger;
+        Matcher<long,long,long> M(&egg, node_excess, &logger);
+        M.match();
+        Matcher<long,long,long> A(&approximate_egg, node_excess, &logger);
+        A.epsilon = 0.2;
+        A.match();
+        for (long round = 0; round < 2; round++) {
+            for (long i = round; i < source_n; i += 2) {
+                M.increaseCapacity(i);
+                A.increaseCapacity(i);
+            }
+            M.calculateResult();
+            A.calculateResult();
+            //the potentials of the exact matching certify its optimality
+            BOOST_CHECK_EQUAL(M.certifiedGap(), 0);
+            //the approximate matching is not better than the optimum and not worse than its certified gap
+            double gap = A.certifiedGap();
+            BOOST_CHECK_GE(A.result_weight, M.result_weight);
+            BOOST_CHECK_LE(A.result_weight, M.result_weight * (1 + gap) + 1e-6);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE (parallelGreedyMatching) {
+    long source_n = 300;
+    long target_n = 40;
+    long target_capacity = 10;
+    for (uint64_t seed = 1; seed < 4; seed++) {
+        std::vector<long> node_excess(source_n + target_n, target_capacity);
+        for (long i = 0; i < source_n; i++) {
+            node_excess[i] = -1 - (i % 3 == 0);
+        }
+        Logger logger;
+        RandomEdgeGenerator egg(source_n, source_n, target_n, target_capacity, seed);
+        Matcher<long,long,long> M(&egg, node_excess, &logger);
+        M.greedyMatching = true;
+        M.greedyMatchingOrder = 3;
+        M.match();
+        M.calculateResult();
+
+        //deterministic chunks give the result of the sequential greedy
+        for (long chunk : {1, 7, 64, 1000}) {
+            RandomEdgeGenerator parallel_egg(source_n, source_n, target_n, target_capacity, seed);
+            Matcher<long,long,long> P(&parallel_egg, node_excess, &logger);
+            P.greedyMatching = true;
+            P.greedyMatchingOrder = 3;
+            P.greedyChunk = chunk;
+            P.match();
+            P.calculateResult();
+            BOOST_CHECK_EQUAL(P.result_weight, M.result_weight);
+            BOOST_CHECK(P.node_excess == M.node_excess);
+        }
+
+        //atomic claims never exceed capacities, also across chunks
+        for (long chunk : {7, 64}) {
+            RandomEdgeGenerator atomic_egg(source_n, source_n, target_n, target_capacity, seed);
+            Matcher<long,long,long> A(&atomic_egg, node_excess, &logger);
+            A.greedyMatching = true;
+            A.greedyMatchingOrder = 3;
+            A.greedyChunk = chunk;
+            A.greedyDeterministic = false;
+            A.match();
+            for (long i = 0; i < source_n; i++) {
+                BOOST_CHECK_LE(A.node_excess[i], 0);
+                BOOST_CHECK_GE(A.node_excess[i], node_excess[i]);
+            }
+            for (long i = source_n; i < source_n + target_n; i++) {
+                BOOST_CHECK_GE(A.node_excess[i], 0);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE (narrowTypesMatching) {
+    long source_n = 40;
+    long target_n = 30;
+    long target_capacity = 2;
+    for (uint64_t seed = 1; seed < 6; seed++) {
+        RandomEdgeGenerator egg(source_n, source_n, target_n, target_capacity, seed);
+        RandomEdgeGenerator narrow_egg(source_n, source_n, target_n, target_capacity, seed);
+        std::vector<long> node_excess(source_n + target_n, target_capacity);
+        std::vector<int32_t> narrow_excess(source_n + target_n, target_capacity);
+        for (long i = 0; i < source_n; i++) {
+            node_excess[i] = -1;
+            narrow_excess[i] = -1;
+        }
+
+        Logger logger;
+        Matcher<long,long,long> M(&egg, node_excess, &logger);
+        M.match();
+        Matcher<int32_t,int32_t,int32_t> N(&narrow_egg, narrow_excess, &logger);
+        N.match();
+        for (long i = 0; i < source_n; i += 2) {
+            BOOST_CHECK_EQUAL(N.increaseCapacity(i), M.increaseCapacity(i));
+        }
+        M.calculateResult();
+        N.calculateResult();
+        BOOST_CHECK_EQUAL(N.result_weight, M.result_weight);
+    }
+}
+
+BOOST_AUTO_TEST_CASE (auctionMatching) {
+    for (uint64_t seed = 1; seed < 21; seed++) {
+        long source_n = 5 + seed * 7 % 37;
+        long target_n = 3 + seed * 11 % 20;
+        long target_capacity = 1 + seed % 4;
+        if (target_n * target_capacity < source_n) {
+            target_n = source_n / target_capacity + 1;
+        }
+        RandomEdgeGenerator egg(source_n, source_n, target_n, target_capacity, seed);
+        RandomEdgeGenerator auction_egg(source_n, source_n, target_n, target_capacity, seed);
+        std::vector<long> node_excess(source_n + target_n, target_capacity);
+        for (long i = 0; i < source_n; i++) {
+            node_excess[i] = -1;
+        }
+
+        Logger logger;
+        Matcher<long,long,long> M(&egg, node_excess, &logger);
+        M.match();
+        M.calculateResult();
+        AuctionMatcher<long,long,long> A(&auction_egg, node_excess, &logger);
+        A.match();
+        A.calculateResult();
+        BOOST_CHECK_EQUAL(A.result_weight, M.result_weight);
+        for (long i = 0; i < source_n; i++) {
+            BOOST_CHECK_EQUAL(A.node_excess[i], 0);
+        }
+        long matched = 0;
+        for (long j = source_n; j < source_n + target_n; j++) {
+            BOOST_CHECK(A.node_excess[j] >= 0);
+            matched += target_capacity - A.node_excess[j];
+        }
+        BOOST_CHECK_EQUAL(matched, source_n);
+    }
+}
+
+BOOST_AUTO_TEST_CASE (auctionMatchingNarrowWeights) {
+    //weights of the extra node scaled by the number of bidders do not fit into int, prices must not overflow
+    long source_n = 1500;
+    long target_n = 300;
+    long target_capacity = 5;
+    RandomEdgeGenerator egg(source_n, source_n, target_n, target_capacity, 1);
+    RandomEdgeGenerator auction_egg(source_n, source_n, target_n, target_capacity, 1);
+    std::vector<long> node_excess(source_n + target_n, target_capacity);
+    for (long i = 0; i < source_n; i++) {
+        node_excess[i] = -1;
+    }
+
+    Logger logger;
+    Matcher<long,int,int> M(&egg, node_excess, &logger);
+    M.match();
+    M.calculateResult();
+    AuctionMatcher<long,int,int> A(&auction_egg, node_excess, &logger);
+    A.match();
+    A.calculateResult();
+    BOOST_CHECK_EQUAL(A.result_weight, M.result_weight);
+}
+
+BOOST_AUTO_TEST_CASE (partitionedMatching) {
+    for (uint64_t seed = 1; seed < 21; seed++) {
+        long source_n = 5 + seed * 7 % 37;
+        long target_n = 3 + seed * 11 % 20;
+        long target_capacity = 1 + seed % 4;
+        long part_count = 1 + seed % 5;
+        if (target_n * target_capacity < source_n) {
+            target_n = source_n / target_capacity + 1;
+        }
+        RandomEdgeGenerator egg(source_n, source_n, target_n, target_capacity, seed);
+        RandomEdgeGenerator partitioned_egg(source_n, source_n, target_n, target_capacity, seed);
+        std::vector<long> node_excess(source_n + target_n, target_capacity);
+        for (long i = 0; i < source_n; i++) {
+            node_excess[i] = -1;
+        }
+        std::vector<Coords> coords;
+        for (long i = 0; i < source_n + target_n; i++) {
+            coords.push_back(Coords(i * 37 % 101, i * 53 % 97));
+        }
+        std::vector<long> part_of = PartitionedMatcher<long,long,long>::hilbertPartition(coords, node_excess, part_count);
+
+        Logger logger;
+        Matcher<long,long,long> M(&egg, node_excess, &logger);
+        M.match();
+        M.calculateResult();
+        PartitionedMatcher<long,long,long> P(&partitioned_egg, node_excess, part_of, part_count, &logger);
+        P.match();
+        P.calculateResult();
+        BOOST_CHECK_EQUAL(P.result_weight, M.result_weight);
+        for (long i = 0; i < source_n; i++) {
+            BOOST_CHECK_EQUAL(P.node_excess[i], 0);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE (hilbertKeysOrder) {
+    //cells of a 16x16 grid are visited by the Hilbert curve one after another
+    std::vector<Coords> coords;
+    for (long i = 0; i < 256; i++) {
+        coords.push_back(Coords(i * 7 % 16, i / 16));
+    }
+    std::vector<uint64_t> keys = compute_hilbert_keys(coords);
+    std::vector<std::pair<uint64_t, long>> ordered;
+    for (long i = 0; i < coords.size(); i++) {
+        ordered.push_back(std::make_pair(keys[i], i));
+    }
+    radix_sort(ordered);
+    for (long i = 1; i < ordered.size(); i++) {
+        Coords a = coords[ordered[i - 1].second];
+        Coords b = coords[ordered[i].second];
+        BOOST_CHECK_EQUAL(std::abs(a.first - b.first) + std::abs(a.second - b.second), 1);
+    }
+
+    //radix sort is stable
+    std::mt19937_64 rng(1);
+    std::vector<std::pair<uint64_t, long>> entries;
+    for (long i = 0; i < 1000; i++) {
+        entries.push_back(std::make_pair(rng() >> (i % 3 == 0 ? 60 : 0), i));
+    }
+    std::vector<std::pair<uint64_t, long>> expected = entries;
+    std::stable_sort(expected.begin(), expected.end(), [](const std::pair<uint64_t, long>& a, const std::pair<uint64_t, long>& b) {
+        return a.first < b.first;
+    });
+    radix_sort(entries);
+    BOOST_CHECK(entries == expected);
+}
+
+BOOST_AUTO_TEST_CASE (dynamicUpdates) {
+    //removed sources and changed capacities are repaired to the matching built from scratch
+    long source_n = 40;
+    long target_n = 30;
+    long target_capacity = 3;
+    for (uint64_t seed = 1; seed < 6; seed++) {
+        RandomEdgeGenerator egg(source_n, source_n, target_n, target_capacity, seed);
+        RandomEdgeGenerator fresh_egg(source_n, source_n, target_n, target_capacity, seed);
+        std::vector<long> node_excess(source_n + target_n, target_capacity);
+        for (long i = 0; i < source_n; i++) {
+            node_excess[i] = -1;
+        }
+
+        Logger logger;
+        Matcher<long,long,long> M(&egg, node_excess, &logger);
+        M.match();
+        for (long i = 0; i < source_n; i += 3) {
+            M.increaseCapacity(i);
+            node_excess[i] = -2;
+        }
+        for (long i = 0; i < source_n; i += 7) {
+            M.removeSource(i);
+            node_excess[i] = 0;
+        }
+        for (long j = 0; j < target_n; j += 5) {
+            M.changeTargetCapacity(source_n + j, 2);
+            node_excess[source_n + j] += 2;
+            M.changeTargetCapacity(source_n + j + 1, -2);
+            node_excess[source_n + j + 1] -= 2;
+        }
+        M.calculateResult();
+
+        Matcher<long,long,long> F(&fresh_egg, node_excess, &logger);
+        F.match();
+        F.calculateResult();
+        BOOST_CHECK_EQUAL(M.result_weight, F.result_weight);
+        for (long i = 0; i < source_n; i++) {
+            BOOST_CHECK_EQUAL(M.node_excess[i], 0);
+        }
+    }
+
+    //sources with several units on a target with a smaller capacity return all their units
+    for (uint64_t seed = 1; seed < 11; seed++) {
+        RandomEdgeGenerator egg(source_n, source_n, target_n, target_capacity + 1, seed);
+        RandomEdgeGenerator fresh_egg(source_n, source_n, target_n, target_capacity + 1, seed);
+        std::vector<long> node_excess(source_n + target_n, target_capacity + 1);
+        for (long i = 0; i < source_n; i++) {
+            node_excess[i] = -2;
+        }
+
+        Logger logger;
+        Matcher<long,long,long> M(&egg, node_excess, &logger);
+        M.match();
+        for (long j = 0; j < target_n; j += 3) {
+            M.changeTargetCapacity(source_n + j, -3);
+            node_excess[source_n + j] -= 3;
+        }
+        M.calculateResult();
+
+        Matcher<long,long,long> F(&fresh_egg, node_excess, &logger);
+        F.match();
+        F.calculateResult();
+        BOOST_CHECK_EQUAL(M.result_weight, F.result_weight);
+        for (long i = 0; i < source_n; i++) {
+            BOOST_CHECK_EQUAL(M.node_excess[i], 0);
+        }
+    }
+
+    //relocated sources generate edges from their new places
+    std::unique_ptr<Network> network = generate_random_geometric_network(200, 0.15, 4);
+    Network& net = *network;
+    ExploringEdgeGenerator<long,long> egg(net);
+    std::vector<long> node_excess(egg.n + egg.m, 1);
+    for (long i = 0; i < egg.n; i++) {
+        node_excess[i] = -1;
+    }
+    Logger logger;
+    Matcher<long,long,long> M(&egg, node_excess, &logger);
+    M.match();
+    for (long i = 0; i < egg.n; i += 5) {
+        net.source_indexes[i] = (net.source_indexes[i] + 2) % net.graph_size();
+        M.relocateSource(i, net.source_indexes[i]);
+    }
+    M.calculateResult();
+
+    ExploringEdgeGenerator<long,long> fresh_egg(net);
+    Matcher<long,long,long> F(&fresh_egg, node_excess, &logger);
+    F.match();
+    F.calculateResult();
+    BOOST_CHECK_EQUAL(M.result_weight, F.result_weight);
+}
@@ -11,6 +11,7 @@
 #include "Matcher.h"
 #include "Network.h"
 #include "ExploringEdgeGenerator.h"
+#include "HeapPolicy.h"
 
 bool check_igraph_vector(igraph_vector_t r, std::vector<uint64_t>& correct) {
     for (int i = 0; i < correct.size(); i++ ) {
@@ -151,4 +152,114 @@ BOOST_AUTO_TEST_CASE (testCopyHeap) {
     BOOST_CHECK_EQUAL(copy.getTopIdx(), 0);
     copy.dequeue();
     BOOST_CHECK_EQUAL(copy.getTopIdx(), 1);
-}
\ No newline at end of file
+}
+/*
+ * Random monotone sequence of operations as in Dijkstra: enqueue, decrease or increase of keys not smaller
+ * than the last dequeued key, removal and dequeue. Returns the dequeued values and indexes
+ * Distinct keys make the sequence the same for any heap, otherwise it depends on tie-breaking
+ */
+template<class Heap>
+std::vector<std::pair<long,long>> runHeapSequence(Heap& heap, uint64_t seed, bool distinct_keys) {
+    std::mt19937_64 rng(seed);
+    std::vector<std::pair<long,long>> result;
+    long last = 0;
+    for (long step = 0; step < 3000; step++) {
+        long idx = rng() % 200;
+        long value = distinct_keys ? ((last >> 8) + 1 + rng() % 50) * 256 + idx : last + rng() % 50;
+        long operation = rng() % 5;
+        if (operation < 2) {
+            heap.updateorenqueue(idx, value);
+        } else if (operation == 2) {
+            heap.remove(idx);
+        } else {
+            long top_idx, top_value;
+            if (heap.dequeue(top_idx, top_value)) {
+                last = top_value;
+                result.push_back(std::make_pair(top_value, top_idx));
+            }
+        }
+        if (step % 1000 == 999) {
+            heap.softClear();
+            last = 0;
+        }
+    }
+    return result;
+}
+
+BOOST_AUTO_TEST_CASE (testHeapPolicies) {
+    for (uint64_t seed = 1; seed < 6; seed++) {
+        fHeap<long, long> reference;
+        auto expected = runHeapSequence(reference, seed, false);
+        //the binary heap keeps the order of fHeap, including ties
+        BinaryHeapPolicy::heap<long, long> binary;
+        BOOST_CHECK(runHeapSequence(binary, seed, false) == expected);
+
+        reference.clear();
+        expected = runHeapSequence(reference, seed, true);
+        DaryHeapPolicy<4>::heap<long, long> quaternary;
+        PairingHeapPolicy::heap<long, long> pairing;
+        RadixHeapPolicy::heap<long, long> radix;
+        auto quaternary_result = runHeapSequence(quaternary, seed, true);
+        auto pairing_result = runHeapSequence(pairing, seed, true);
+        auto radix_result = runHeapSequence(radix, seed, true);
+        BOOST_REQUIRE_EQUAL(quaternary_result.size(), expected.size());
+        BOOST_REQUIRE_EQUAL(pairing_result.size(), expected.size());
+        BOOST_REQUIRE_EQUAL(radix_result.size(), expected.size());
+        for (long i = 0; i < expected.size(); i++) {
+            BOOST_CHECK(quaternary_result[i] == expected[i]);
+            BOOST_CHECK(pairing_result[i] == expected[i]);
+            BOOST_CHECK(radix_result[i] == expected[i]);
+        }
+    }
+
+    //max-heap with a compile-time comparator instead of fHeap.sign
+    DaryHeapPolicy<4>::heap<long, long, std::greater<long>> max_heap;
+    max_heap.enqueue(0, 10);
+    max_heap.enqueue(1, 20);
+    max_heap.enqueue(2, 5);
+    BOOST_CHECK_EQUAL(max_heap.getTopIdx(), 1);
+    max_heap.updatequeue(2, 30);
+    BOOST_CHECK_EQUAL(max_heap.dequeue(), 2);
+    BOOST_CHECK_EQUAL(max_heap.dequeue(), 1);
+}
+
+BOOST_AUTO_TEST_CASE (testCoverageBucketQueue) {
+    //lazy greedy over coverages: the bucket queue dequeues facilities in the order of a heap of FacilityRank
+    std::mt19937_64 rng(1);
+    BinaryHeapPolicy::heap<FacilityRank, long, std::greater<FacilityRank>> heap;
+    BucketQueuePolicy::heap<FacilityRank, long> buckets;
+    long facility_count = 500;
+    for (long i = 0; i < facility_count; i++) {
+        FacilityRank rank(rng() % 20, rng() % 3 - 1, i);
+        heap.enqueue(i, rank);
+        buckets.enqueue(i, rank);
+    }
+    for (long round = 0; round < 3; round++) {
+        std::vector<long> dequeued;
+        long facility;
+        FacilityRank rank;
+        while (heap.size() > facility_count / 2) {
+            BOOST_CHECK_EQUAL(buckets.getTopIdx(), heap.getTopIdx());
+            heap.dequeue(facility, rank);
+            long bucket_facility;
+            FacilityRank bucket_rank;
+            buckets.dequeue(bucket_facility, bucket_rank);
+            BOOST_REQUIRE_EQUAL(bucket_facility, facility);
+            dequeued.push_back(facility);
+            if (rank.coverage > 0 && rng() % 2 == 0) {
+                rank.coverage -= 1 + rng() % rank.coverage;
+                heap.enqueue(facility, rank);
+                buckets.enqueue(facility, rank);
+            }
+        }
+        //ranks change between rounds, coverage may grow
+        for (long i = 0; i < facility_count; i++) {
+            if (std::find(dequeued.begin(), dequeued.end(), i) != dequeued.end() || rng() % 10 == 0) {
+                FacilityRank rank(rng() % 20, round, i);
+                heap.updateorenqueue(i, rank);
+                buckets.updateorenqueue(i, rank);
+            }
+        }
+        BOOST_CHECK_EQUAL(buckets.size(), heap.size());
+    }
+}